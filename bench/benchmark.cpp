@@ -0,0 +1,160 @@
+
+#include "benchmark.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+static std::string jsonField(const std::string &line, const std::string &key);
+
+Benchmark::Benchmark(const std::string &filter, double minSeconds):
+    filter(filter), minSeconds(minSeconds), failures(0)
+{
+}
+
+void Benchmark::add(const std::string &name, double value, const std::string &unit, bool higherIsBetter)
+{
+    results.push_back(Result{name, value, unit, higherIsBetter});
+    std::cerr << std::left << std::setw(48) << name << std::right << std::setw(14) << std::fixed << std::setprecision(3)
+        << value << " " << unit << std::endl;
+}
+
+int Benchmark::compare(const std::vector<Result> &baseline, double threshold, std::ostream &out) const
+{
+    // A result regresses when it is worse than the baseline by more than the
+    // threshold, as a fraction of the baseline
+    std::map<std::string, double> baselineValues;
+    for (const Result &result: baseline) {
+        baselineValues[result.name] = result.value;
+    }
+
+    int regressions = 0;
+    for (const Result &result: results) {
+        auto it = baselineValues.find(result.name);
+        if (it == baselineValues.end() || it->second == 0.0) {
+            continue;
+        }
+        double change = (result.value - it->second) / it->second;
+        bool regressed = result.higherIsBetter ? change < -threshold : change > threshold;
+        regressions += regressed;
+        out << (regressed ? "REGRESSION " : "           ") << std::left << std::setw(48) << result.name << std::right
+            << std::showpos << std::fixed << std::setprecision(1) << change * 100.0 << std::noshowpos << "%" << std::endl;
+    }
+    return regressions;
+}
+
+void Benchmark::expect(bool condition, const std::string &message)
+{
+    if (!condition) {
+        failures++;
+        std::cerr << "FAILED " << message << std::endl;
+    }
+}
+
+bool Benchmark::isSelected(const std::string &name) const
+{
+    return name.find(filter) != std::string::npos;
+}
+
+double Benchmark::measure(const std::function<void()> &operation) const
+{
+    // Nanoseconds per call in the fastest of a few rounds, which is less
+    // noisy than the mean. A first call warms up the caches.
+    const int rounds = 5;
+    operation();
+    double best = 0.0;
+    for (int round = 0; round < rounds; round++) {
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed(0.0);
+        long calls = 0;
+        while (elapsed.count() < minSeconds / rounds) {
+            operation();
+            calls++;
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        double time = elapsed.count() * 1e9 / calls;
+        best = (round == 0 || time < best) ? time : best;
+    }
+    return best;
+}
+
+std::vector<Benchmark::Result> Benchmark::read(const std::string &path)
+{
+    // Reads the files written by writeJson or writeCsv
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("cannot open " + path);
+    }
+
+    std::vector<Result> results;
+    std::string line;
+    bool json = in.peek() == '[';
+    if (!json) {
+        std::getline(in, line);
+    }
+    while (std::getline(in, line)) {
+        Result result;
+        if (json) {
+            if (line.find("\"name\"") == std::string::npos) {
+                continue;
+            }
+            result.name = jsonField(line, "name");
+            result.value = std::atof(jsonField(line, "value").c_str());
+            result.unit = jsonField(line, "unit");
+            result.higherIsBetter = jsonField(line, "higher_is_better") == "true";
+        } else {
+            std::istringstream fields(line);
+            std::string value;
+            std::string higherIsBetter;
+            std::getline(fields, result.name, ',');
+            std::getline(fields, value, ',');
+            std::getline(fields, result.unit, ',');
+            std::getline(fields, higherIsBetter, ',');
+            result.value = std::atof(value.c_str());
+            result.higherIsBetter = higherIsBetter == "1";
+        }
+        results.push_back(result);
+    }
+    return results;
+}
+
+void Benchmark::writeCsv(std::ostream &out) const
+{
+    out << "name,value,unit,higher_is_better" << std::endl;
+    for (const Result &result: results) {
+        out << result.name << "," << std::setprecision(9) << result.value << "," << result.unit << ","
+            << result.higherIsBetter << std::endl;
+    }
+}
+
+void Benchmark::writeJson(std::ostream &out) const
+{
+    // One result per line, so that the baseline can be read without a JSON
+    // library
+    out << "[" << std::endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &result = results[i];
+        out << "  {\"name\": \"" << result.name << "\", \"value\": " << std::setprecision(9) << result.value
+            << ", \"unit\": \"" << result.unit << "\", \"higher_is_better\": " << (result.higherIsBetter ? "true" : "false")
+            << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "]" << std::endl;
+}
+
+std::string jsonField(const std::string &line, const std::string &key)
+{
+    size_t start = line.find("\"" + key + "\":");
+    if (start == std::string::npos) {
+        return "";
+    }
+    start = line.find_first_not_of(" ", start + key.size() + 3);
+    if (line[start] == '"') {
+        return line.substr(start + 1, line.find('"', start + 1) - start - 1);
+    }
+    return line.substr(start, line.find_first_of(",}", start) - start);
+}
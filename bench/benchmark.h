@@ -0,0 +1,46 @@
+#ifndef PINTA_BENCH_BENCHMARK_H
+#define PINTA_BENCH_BENCHMARK_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Collects the results of the scenarios of pinta-bench, writes them as JSON
+// or CSV and compares them against the results of a previous run.
+class Benchmark {
+
+public:
+
+    struct Result {
+        std::string name;
+        double value;
+        std::string unit;
+        bool higherIsBetter;
+    };
+
+    Benchmark(const std::string &filter, double minSeconds);
+
+    void add(const std::string &name, double value, const std::string &unit, bool higherIsBetter = false);
+    int compare(const std::vector<Result> &baseline, double threshold, std::ostream &out) const;
+    // Records a failure, reported at once, when a scenario breaks a bound
+    // that doesn't depend on the timings
+    void expect(bool condition, const std::string &message);
+    inline int getFailures() const {return failures;}
+    inline const std::vector<Result> & getResults() const {return results;}
+    bool isSelected(const std::string &name) const;
+    double measure(const std::function<void()> &operation) const;
+    static std::vector<Result> read(const std::string &path);
+    void writeCsv(std::ostream &out) const;
+    void writeJson(std::ostream &out) const;
+
+private:
+
+    std::string filter;
+    double minSeconds;
+    std::vector<Result> results;
+    int failures;
+
+};
+
+#endif
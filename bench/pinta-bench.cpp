@@ -0,0 +1,528 @@
+
+#include "benchmark.h"
+
+#include "pinta/circlepoints.h"
+#include "pinta/commandlist.h"
+#include "pinta/damagetracker.h"
+#include "pinta/drawlist.h"
+#include "pinta/lodshape.h"
+#include "pinta/meshfactory.h"
+#include "pinta/meshstore.h"
+#include "pinta/offscreendisplay.h"
+#include "pinta/pathtessellator.h"
+#include "pinta/renderer.h"
+#include "pinta/scene.h"
+#include "pinta/sdfshape.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pinta;
+
+static const int WIDTH = 640;
+static const int HEIGHT = 480;
+static const int MESH_COUNTS[] = {100, 1000, 10000};
+
+static std::string name(const std::string &scenario, const std::string &parameter, int value);
+static std::vector<Mesh *> randomMeshes(int count, std::mt19937 &random);
+static void runChurn(Benchmark &benchmark, OffscreenDisplay &display);
+static void runFrames(Benchmark &benchmark, OffscreenDisplay &display);
+static void runTessellation(Benchmark &benchmark);
+static void runUpload(Benchmark &benchmark, OffscreenDisplay &display);
+static void usage();
+
+int main(int argc, char **argv)
+{
+    std::string format = "json";
+    std::string output;
+    std::string baseline;
+    std::string filter;
+    double threshold = 0.1;
+    double minSeconds = 0.2;
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--csv") {
+            format = "csv";
+        } else if (option == "--json") {
+            format = "json";
+        } else if (option == "--output" && hasValue) {
+            output = argv[++i];
+        } else if (option == "--baseline" && hasValue) {
+            baseline = argv[++i];
+        } else if (option == "--threshold" && hasValue) {
+            threshold = std::atof(argv[++i]) / 100.0;
+        } else if (option == "--filter" && hasValue) {
+            filter = argv[++i];
+        } else if (option == "--time" && hasValue) {
+            minSeconds = std::atof(argv[++i]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    Benchmark benchmark(filter, minSeconds);
+    OffscreenDisplay display(WIDTH, HEIGHT);
+    std::cerr << "GL_RENDERER: " << glGetString(GL_RENDERER) << std::endl;
+    runTessellation(benchmark);
+    runUpload(benchmark, display);
+    runFrames(benchmark, display);
+    runChurn(benchmark, display);
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output);
+    }
+    std::ostream &out = output.empty() ? std::cout : file;
+    if (format == "csv") {
+        benchmark.writeCsv(out);
+    } else {
+        benchmark.writeJson(out);
+    }
+
+    if (!baseline.empty()) {
+        int regressions = benchmark.compare(Benchmark::read(baseline), threshold, std::cerr);
+        std::cerr << regressions << " regressions over " << threshold * 100.0 << "%" << std::endl;
+        return (regressions || benchmark.getFailures()) ? 1 : 0;
+    }
+    return benchmark.getFailures() ? 1 : 0;
+}
+
+std::string name(const std::string &scenario, const std::string &parameter, int value)
+{
+    return scenario + "/" + parameter + "=" + std::to_string(value);
+}
+
+std::vector<Mesh *> randomMeshes(int count, std::mt19937 &random)
+{
+    // Small shapes spread over the viewport, as separate meshes
+    std::uniform_real_distribution<float> x(-WIDTH / 2.0, WIDTH / 2.0);
+    std::uniform_real_distribution<float> y(-HEIGHT / 2.0, HEIGHT / 2.0);
+    std::uniform_int_distribution<int> channel(0, 255);
+    std::vector<Mesh *> meshes;
+    for (int i = 0; i < count; i++) {
+        Color color(channel(random), channel(random), channel(random));
+        Mesh *mesh = (i % 2) ? rectangle(12, 8, 2, color, 4) : circle(5, color, 16);
+        std::vector<Vertex> vertices = mesh->getVertices();
+        float dx = x(random);
+        float dy = y(random);
+        for (Vertex &vertex: vertices) {
+            vertex.position[0] += dx;
+            vertex.position[1] += dy;
+        }
+        mesh->setVertices(vertices);
+        meshes.push_back(mesh);
+    }
+    return meshes;
+}
+
+void runChurn(Benchmark &benchmark, OffscreenDisplay &display)
+{
+    const int frames = 300;
+    const int meshCount = 1000;
+    std::mt19937 random(7);
+
+    if (benchmark.isSelected("churn/add-one-per-frame")) {
+        // The scene grows by one mesh every frame
+        Renderer renderer(WIDTH, HEIGHT);
+        std::vector<Mesh *> meshes = randomMeshes(frames, random);
+        std::list<const Mesh *> drawn;
+        auto start = std::chrono::steady_clock::now();
+        for (Mesh *mesh: meshes) {
+            drawn.push_back(mesh);
+            renderer.clear();
+            renderer.resetTransformations();
+            renderer.translate(glm::vec2(0.0, 0.0));
+            renderer.draw(drawn);
+            display.swap();
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        benchmark.add(name("churn/add-one-per-frame", "frames", frames), elapsed.count() / frames, "ms/frame");
+        for (Mesh *mesh: meshes) {
+            delete mesh;
+        }
+    }
+
+    if (benchmark.isSelected("churn/recolor")) {
+        // A tenth of the meshes change color every frame
+        Renderer renderer(WIDTH, HEIGHT);
+        std::vector<Mesh *> meshes = randomMeshes(meshCount, random);
+        std::list<const Mesh *> drawn(meshes.begin(), meshes.end());
+        int frame = 0;
+        double time = benchmark.measure([&]() {
+            for (int i = 0; i < meshCount / 10; i++) {
+                meshes[(frame * 97 + i * 10) % meshCount]->setColor(Color(frame % 256, i % 256, 128));
+            }
+            frame++;
+            renderer.clear();
+            renderer.resetTransformations();
+            renderer.translate(glm::vec2(0.0, 0.0));
+            renderer.draw(drawn);
+            display.swap();
+        });
+        benchmark.add(name("churn/recolor", "meshes", meshCount), time / 1e6, "ms/frame");
+        for (Mesh *mesh: meshes) {
+            delete mesh;
+        }
+    }
+
+    if (benchmark.isSelected("churn/replace")) {
+        // One percent of the meshes are replaced by new ones every frame
+        Renderer renderer(WIDTH, HEIGHT);
+        std::vector<Mesh *> meshes = randomMeshes(meshCount, random);
+        int frame = 0;
+        double time = benchmark.measure([&]() {
+            for (int i = 0; i < meshCount / 100; i++) {
+                Mesh *&mesh = meshes[(frame * 31 + i * 100) % meshCount];
+                renderer.release(mesh);
+                delete mesh;
+                mesh = randomMeshes(1, random)[0];
+            }
+            frame++;
+            renderer.clear();
+            renderer.resetTransformations();
+            renderer.translate(glm::vec2(0.0, 0.0));
+            renderer.draw(std::list<const Mesh *>(meshes.begin(), meshes.end()));
+            display.swap();
+        });
+        benchmark.add(name("churn/replace", "meshes", meshCount), time / 1e6, "ms/frame");
+        for (Mesh *mesh: meshes) {
+            delete mesh;
+        }
+    }
+}
+
+void runFrames(Benchmark &benchmark, OffscreenDisplay &display)
+{
+    std::mt19937 random(3);
+    for (int count: MESH_COUNTS) {
+        std::vector<Mesh *> meshes = randomMeshes(count, random);
+        std::list<const Mesh *> drawn(meshes.begin(), meshes.end());
+
+        for (bool compact: {false, true}) {
+            std::string scenario = compact ? "frame/list-compact" : "frame/list";
+            if (!benchmark.isSelected(name(scenario, "meshes", count))) {
+                continue;
+            }
+            Renderer renderer(WIDTH, HEIGHT);
+            renderer.setCompactVertices(compact);
+            unsigned long frames = 0;
+            double time = benchmark.measure([&]() {
+                renderer.clear();
+                renderer.resetTransformations();
+                renderer.translate(glm::vec2(0.0, 0.0));
+                renderer.draw(drawn);
+                display.swap();
+                frames++;
+            });
+            benchmark.add(name(scenario, "meshes", count), time / 1e6, "ms/frame");
+            benchmark.add(name(scenario, "meshes", count) + "/draw-calls", double(renderer.getDrawCalls()) / frames,
+                "calls/frame");
+        }
+
+        if (benchmark.isSelected(name("frame/drawlist", "meshes", count))) {
+            // Shared shapes placed and colored per item, as in a scene of
+            // repeated symbols
+            std::shared_ptr<const Mesh> square = sharedRectangle(8, 8);
+            std::shared_ptr<const Mesh> dot = sharedCircle(4, 16);
+            std::uniform_real_distribution<float> x(-WIDTH / 2.0, WIDTH / 2.0);
+            std::uniform_real_distribution<float> y(-HEIGHT / 2.0, HEIGHT / 2.0);
+            DrawList drawList;
+            size_t vertices = 0;
+            for (int i = 0; i < count; i++) {
+                const Mesh *mesh = (i % 2) ? square.get() : dot.get();
+                drawList.add(mesh, glm::vec2(x(random), y(random)), glm::vec2(1.0, 1.0), DrawState(), 0,
+                    Color(i % 256, 128, 255 - i % 256));
+                vertices += mesh->getVertices().size();
+            }
+            Renderer renderer(WIDTH, HEIGHT);
+            unsigned long frames = 0;
+            double time = benchmark.measure([&]() {
+                renderer.clear();
+                renderer.resetTransformations();
+                renderer.draw(drawList);
+                display.swap();
+                frames++;
+            });
+            benchmark.add(name("frame/drawlist", "meshes", count), time / 1e6, "ms/frame");
+            benchmark.add(name("frame/drawlist", "meshes", count) + "/draw-calls", double(renderer.getDrawCalls()) / frames,
+                "calls/frame");
+            // All the items have the same state, so only the vertices they
+            // stream may take more than one draw call
+            benchmark.expect(renderer.getDrawCalls() / frames <= 1 + vertices / 65536,
+                name("frame/drawlist", "meshes", count) + " takes a draw call per item");
+        }
+
+        if (benchmark.isSelected(name("frame/damage", "meshes", count))) {
+            // The same kind of scene where only a progress bar changes, drawn
+            // again only where it changed
+            std::shared_ptr<const Mesh> square = sharedRectangle(8, 8);
+            std::shared_ptr<const Mesh> bar = sharedRectangle(4, 8);
+            std::uniform_real_distribution<float> x(-WIDTH / 2.0, WIDTH / 2.0);
+            std::uniform_real_distribution<float> y(-HEIGHT / 2.0, HEIGHT / 2.0);
+            DrawList drawList;
+            for (int i = 0; i < count; i++) {
+                drawList.add(square.get(), glm::vec2(x(random), y(random)), glm::vec2(1.0, 1.0), DrawState(), 0,
+                    Color(i % 256, 128, 255 - i % 256));
+            }
+            DrawList progress;
+            Renderer renderer(WIDTH, HEIGHT);
+            CommandList commands;
+            DamageTracker damage(WIDTH, HEIGHT);
+            unsigned long frames = 0;
+            double time = benchmark.measure([&]() {
+                progress.clear();
+                progress.add(bar.get(), glm::vec2(-WIDTH / 2.0 + frames % WIDTH, 0.0), glm::vec2(1.0, 1.0), DrawState(), 1,
+                    Color(255, 255, 255));
+                commands.reset();
+                commands.clear();
+                commands.resetTransformations();
+                commands.draw(drawList);
+                commands.draw(progress);
+                renderer.setDamage(damage.update(commands));
+                commands.replay(renderer);
+                display.swap();
+                frames++;
+            });
+            benchmark.add(name("frame/damage", "meshes", count), time / 1e6, "ms/frame");
+        }
+
+        if (benchmark.isSelected(name("frame/rounded-mesh", "shapes", count))
+                || benchmark.isSelected(name("frame/rounded-lod", "shapes", count))
+                || benchmark.isSelected(name("frame/rounded-sdf", "shapes", count))) {
+            // Small rounded widgets, each one a mesh of its own or a quad
+            std::uniform_real_distribution<float> x(-WIDTH / 2.0, WIDTH / 2.0);
+            std::uniform_real_distribution<float> y(-HEIGHT / 2.0, HEIGHT / 2.0);
+            std::vector<SdfShape> shapes;
+            std::vector<Mesh *> roundedMeshes;
+            for (int i = 0; i < count; i++) {
+                Color color(i % 256, 128, 255 - i % 256);
+                shapes.push_back(SdfShape::rectangle(glm::vec2(x(random), y(random)), 24, 12, 4, color));
+                roundedMeshes.push_back(rectangle(24, 12, 4, color));
+            }
+            DrawList drawList;
+            for (int i = 0; i < count; i++) {
+                drawList.add(roundedMeshes[i], shapes[i].position, glm::vec2(1.0, 1.0), DrawState(), 0, Color(255, 255, 255));
+            }
+            // The same widgets tessellated for their size on the screen
+            LodShape widget(ShapeDescription::rectangle(24, 12, 4, Color(255, 255, 255)));
+            DrawList lodList;
+            for (int i = 0; i < count; i++) {
+                lodList.add(&widget, shapes[i].position, glm::vec2(1.0, 1.0), DrawState(), 0, shapes[i].color);
+            }
+
+            if (benchmark.isSelected(name("frame/rounded-mesh", "shapes", count))) {
+                Renderer renderer(WIDTH, HEIGHT);
+                double time = benchmark.measure([&]() {
+                    renderer.clear();
+                    renderer.resetTransformations();
+                    renderer.draw(drawList);
+                    display.swap();
+                });
+                benchmark.add(name("frame/rounded-mesh", "shapes", count), time / 1e6, "ms/frame");
+            }
+            if (benchmark.isSelected(name("frame/rounded-lod", "shapes", count))) {
+                Renderer renderer(WIDTH, HEIGHT);
+                double time = benchmark.measure([&]() {
+                    renderer.clear();
+                    renderer.resetTransformations();
+                    renderer.draw(lodList);
+                    display.swap();
+                });
+                benchmark.add(name("frame/rounded-lod", "shapes", count), time / 1e6, "ms/frame");
+            }
+            if (benchmark.isSelected(name("frame/rounded-sdf", "shapes", count))) {
+                Renderer renderer(WIDTH, HEIGHT);
+                double time = benchmark.measure([&]() {
+                    renderer.clear();
+                    renderer.resetTransformations();
+                    renderer.draw(shapes.data(), shapes.size());
+                    display.swap();
+                });
+                benchmark.add(name("frame/rounded-sdf", "shapes", count), time / 1e6, "ms/frame");
+            }
+            for (Mesh *mesh: roundedMeshes) {
+                delete mesh;
+            }
+        }
+
+        if (benchmark.isSelected(name("frame/store", "meshes", count))) {
+            MeshStore store;
+            std::vector<MeshHandle> handles;
+            for (const Mesh *mesh: meshes) {
+                handles.push_back(store.add(*mesh));
+            }
+            Renderer renderer(WIDTH, HEIGHT);
+            double time = benchmark.measure([&]() {
+                renderer.clear();
+                renderer.resetTransformations();
+                renderer.translate(glm::vec2(0.0, 0.0));
+                renderer.draw(store, handles.data(), handles.size());
+                display.swap();
+            });
+            benchmark.add(name("frame/store", "meshes", count), time / 1e6, "ms/frame");
+        }
+
+        if (benchmark.isSelected(name("frame/scene-culled", "nodes", count))) {
+            // Nodes over an area ten times the viewport in each direction
+            Scene scene;
+            std::uniform_real_distribution<float> x(-5.0 * WIDTH, 5.0 * WIDTH);
+            std::uniform_real_distribution<float> y(-5.0 * HEIGHT, 5.0 * HEIGHT);
+            for (const Mesh *mesh: meshes) {
+                scene.createNode(nullptr, mesh)->setPosition(glm::vec2(x(random), y(random)));
+            }
+            Renderer renderer(WIDTH, HEIGHT);
+            double time = benchmark.measure([&]() {
+                renderer.clear();
+                renderer.resetTransformations();
+                renderer.draw(scene);
+                display.swap();
+            });
+            benchmark.add(name("frame/scene-culled", "nodes", count), time / 1e6, "ms/frame");
+        }
+
+        for (Mesh *mesh: meshes) {
+            delete mesh;
+        }
+    }
+}
+
+void runTessellation(Benchmark &benchmark)
+{
+    // Uncached shapes are measured with an empty cache budget
+    TessellationCache &cache = tessellationCache();
+    size_t budget = cache.getBudget();
+    for (int segments: {8, 32, 128}) {
+        for (bool cached: {false, true}) {
+            cache.setBudget(cached ? budget : 0);
+            std::string circleName = name(cached ? "tessellate/circle-cached" : "tessellate/circle", "segments", segments);
+            if (benchmark.isSelected(circleName)) {
+                benchmark.add(circleName, benchmark.measure([segments]() {
+                    delete circle(100, Color(255, 0, 0), segments);
+                }), "ns/op");
+            }
+            std::string rectangleName = name(cached ? "tessellate/rectangle-cached" : "tessellate/rectangle", "segments",
+                segments / 4);
+            if (benchmark.isSelected(rectangleName)) {
+                benchmark.add(rectangleName, benchmark.measure([segments]() {
+                    delete rectangle(100, 50, 10, Color(255, 0, 0), segments / 4);
+                }), "ns/op");
+            }
+        }
+    }
+    cache.setBudget(budget);
+
+    if (benchmark.isSelected("tessellate/circle-points")) {
+        std::vector<Vertex> vertices(4096);
+        double time = benchmark.measure([&vertices]() {
+            circlePoints(0.0, 0.0, 100.0, 0.0, 0.001, vertices.size(), vertices.data());
+        });
+        benchmark.add(name("tessellate/circle-points", "count", vertices.size()), vertices.size() * 1e3 / time,
+            "Mvertices/s", true);
+    }
+    if (benchmark.isSelected("tessellate/circle-points-scalar")) {
+        std::vector<Vertex> vertices(4096);
+        double time = benchmark.measure([&vertices]() {
+            circlePointsScalar(0.0, 0.0, 100.0, 0.0, 0.001, vertices.size(), vertices.data());
+        });
+        benchmark.add(name("tessellate/circle-points-scalar", "count", vertices.size()), vertices.size() * 1e3 / time,
+            "Mvertices/s", true);
+    }
+
+    // A batch of mixed shapes on one thread and on all of them
+    std::vector<ShapeDescription> shapes;
+    for (int i = 0; i < 10000; i++) {
+        shapes.push_back(i % 2 ? ShapeDescription::circle(10 + i % 50, Color(255, 0, 0), 8 + i % 64)
+            : ShapeDescription::rectangle(100, 50, i % 20, Color(255, 0, 0), 2 + i % 16));
+    }
+    std::vector<unsigned int> threadCounts = {1};
+    if (threadPool().getThreads() > 1) {
+        threadCounts.push_back(threadPool().getThreads());
+    }
+    for (unsigned int threads: threadCounts) {
+        std::string batchName = name("tessellate/batch", "threads", threads);
+        if (benchmark.isSelected(batchName)) {
+            ThreadPool pool(threads);
+            MeshBatch batch;
+            double time = benchmark.measure([&]() {
+                tessellate(shapes, batch, pool);
+            });
+            benchmark.add(batchName, shapes.size() * 1e3 / time, "Mshapes/s", true);
+        }
+    }
+
+    // A chart of many points as a single mesh, into arrays reused by every run
+    const int chartPoints = 100000;
+    Path line;
+    Path area;
+    for (int i = 0; i < chartPoints; i++) {
+        glm::vec2 point(i * float(WIDTH) / chartPoints, 100 * std::sin(i * 0.01) + 20 * std::sin(i * 0.37));
+        line.lineTo(point);
+        area.lineTo(point);
+    }
+    area.lineTo(glm::vec2(WIDTH, -200));
+    area.lineTo(glm::vec2(0, -200));
+    area.close();
+    PathTessellator tessellator;
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    if (benchmark.isSelected(name("tessellate/path-stroke", "points", chartPoints))) {
+        double time = benchmark.measure([&]() {
+            vertices.clear();
+            indices.clear();
+            tessellator.stroke(line, StrokeStyle(2.0, StrokeStyle::ROUND_JOIN), Color(255, 0, 0), vertices, indices);
+        });
+        benchmark.add(name("tessellate/path-stroke", "points", chartPoints), time / 1e6, "ms/op");
+    }
+    if (benchmark.isSelected(name("tessellate/path-fill", "points", chartPoints))) {
+        double time = benchmark.measure([&]() {
+            vertices.clear();
+            indices.clear();
+            tessellator.fill(area, Color(255, 0, 0), vertices, indices);
+        });
+        benchmark.add(name("tessellate/path-fill", "points", chartPoints), time / 1e6, "ms/op");
+    }
+}
+
+void runUpload(Benchmark &benchmark, OffscreenDisplay &display)
+{
+    // Uploading every mesh for the first time and releasing it afterwards
+    std::mt19937 random(5);
+    for (int count: MESH_COUNTS) {
+        if (!benchmark.isSelected(name("upload", "meshes", count))) {
+            continue;
+        }
+        std::vector<Mesh *> meshes = randomMeshes(count, random);
+        std::list<const Mesh *> drawn(meshes.begin(), meshes.end());
+        Renderer renderer(WIDTH, HEIGHT);
+        double time = benchmark.measure([&]() {
+            renderer.draw(drawn);
+            display.swap();
+            for (const Mesh *mesh: meshes) {
+                renderer.release(mesh);
+            }
+        });
+        benchmark.add(name("upload", "meshes", count), time / 1e6, "ms/op");
+        for (Mesh *mesh: meshes) {
+            delete mesh;
+        }
+    }
+}
+
+void usage()
+{
+    std::cerr << "usage: pinta-bench [--json | --csv] [--output FILE] [--baseline FILE] [--threshold PERCENT]"
+        << " [--filter TEXT] [--time SECONDS]" << std::endl
+        << "Runs the benchmarks whose names contain TEXT on an offscreen display and writes the results. With a"
+        << std::endl << "baseline from a previous run, exits with 1 if a result got worse by more than PERCENT (10)."
+        << std::endl;
+}
@@ -0,0 +1,210 @@
+
+#include "pinta/animationengine.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace pinta {
+
+const float AnimationEngine::EASING_COEFFICIENTS[EASINGS][3] = {
+    {0, 0, 1},
+    {0, 1, 0},
+    {0, -1, 2},
+    {-2, 3, 0}
+};
+
+template <typename T>
+static void removeField(std::vector<T> &fields, size_t index);
+
+static inline float interpolate(float startValue, float endValue, float t);
+static inline Color interpolate(const Color &startColor, const Color &endColor, float t);
+static inline uint8_t interpolateChannel(uint8_t start, uint8_t end, float t);
+
+AnimationEngine::AnimationEngine()
+{
+}
+
+void AnimationEngine::animate(float *target, float startValue, float endValue, float duration, Easing easing,
+    float delay)
+{
+    add(values, target, startValue, endValue, duration, easing, delay);
+}
+
+void AnimationEngine::animate(Color *target, const Color &startColor, const Color &endColor, float duration,
+    Easing easing, float delay)
+{
+    add(colors, target, startColor, endColor, duration, easing, delay);
+}
+
+void AnimationEngine::cancel(const float *target)
+{
+    remove(values, target);
+}
+
+void AnimationEngine::cancel(const Color *target)
+{
+    remove(colors, target);
+}
+
+void AnimationEngine::clear()
+{
+    values = Tracks<float>();
+    colors = Tracks<Color>();
+}
+
+void AnimationEngine::reserve(size_t valueTracks, size_t colorTracks)
+{
+    reserve(values, valueTracks);
+    reserve(colors, colorTracks);
+    progress.reserve(std::max(valueTracks, colorTracks));
+    easedProgress.reserve(std::max(valueTracks, colorTracks));
+}
+
+void AnimationEngine::update(float delta)
+{
+    update(values, delta);
+    update(colors, delta);
+}
+
+template <typename T>
+void AnimationEngine::add(Tracks<T> &tracks, T *target, const T &startValue, const T &endValue, float duration,
+    Easing easing, float delay)
+{
+    if (duration <= 0 && delay <= 0) {
+        remove(tracks, target);
+        *target = endValue;
+        return;
+    }
+
+    *target = startValue;
+    size_t i = tracks.indices.find(target);
+    if (i != IndexTable::NONE) {
+        tracks.elapsed[i] = -delay;
+        tracks.inverseDurations[i] = 1 / std::max(duration, FLT_MIN);
+        tracks.cubic[i] = EASING_COEFFICIENTS[easing][0];
+        tracks.quadratic[i] = EASING_COEFFICIENTS[easing][1];
+        tracks.linear[i] = EASING_COEFFICIENTS[easing][2];
+        tracks.startValues[i] = startValue;
+        tracks.endValues[i] = endValue;
+        return;
+    }
+    tracks.indices.insert(target, tracks.targets.size());
+    tracks.elapsed.push_back(-delay);
+    tracks.inverseDurations.push_back(1 / std::max(duration, FLT_MIN));
+    tracks.cubic.push_back(EASING_COEFFICIENTS[easing][0]);
+    tracks.quadratic.push_back(EASING_COEFFICIENTS[easing][1]);
+    tracks.linear.push_back(EASING_COEFFICIENTS[easing][2]);
+    tracks.startValues.push_back(startValue);
+    tracks.endValues.push_back(endValue);
+    tracks.targets.push_back(target);
+}
+
+template <typename T>
+void AnimationEngine::remove(Tracks<T> &tracks, const T *target)
+{
+    size_t index = tracks.indices.find(target);
+    if (index != IndexTable::NONE) {
+        remove(tracks, index);
+    }
+}
+
+template <typename T>
+void AnimationEngine::remove(Tracks<T> &tracks, size_t index)
+{
+    // The last track takes the place of the removed one, so only its index
+    // changes
+    tracks.indices.erase(tracks.targets[index]);
+    if (index + 1 < tracks.targets.size()) {
+        tracks.indices.insert(tracks.targets.back(), index);
+    }
+    removeField(tracks.elapsed, index);
+    removeField(tracks.inverseDurations, index);
+    removeField(tracks.cubic, index);
+    removeField(tracks.quadratic, index);
+    removeField(tracks.linear, index);
+    removeField(tracks.startValues, index);
+    removeField(tracks.endValues, index);
+    removeField(tracks.targets, index);
+}
+
+template <typename T>
+void AnimationEngine::reserve(Tracks<T> &tracks, size_t count)
+{
+    tracks.elapsed.reserve(count);
+    tracks.inverseDurations.reserve(count);
+    tracks.cubic.reserve(count);
+    tracks.quadratic.reserve(count);
+    tracks.linear.reserve(count);
+    tracks.startValues.reserve(count);
+    tracks.endValues.reserve(count);
+    tracks.targets.reserve(count);
+    tracks.indices.reserve(count);
+}
+
+template <typename T>
+void AnimationEngine::update(Tracks<T> &tracks, float delta)
+{
+    size_t count = tracks.targets.size();
+    if (count == 0) {
+        return;
+    }
+
+    progress.resize(count);
+    easedProgress.resize(count);
+    float *elapsed = tracks.elapsed.data();
+    const float *inverseDurations = tracks.inverseDurations.data();
+    const float *cubic = tracks.cubic.data();
+    const float *quadratic = tracks.quadratic.data();
+    const float *linear = tracks.linear.data();
+    for (size_t i = 0; i < count; i++) {
+        elapsed[i] += delta;
+        progress[i] = std::min(std::max(elapsed[i] * inverseDurations[i], 0.0f), 1.0f);
+    }
+    for (size_t i = 0; i < count; i++) {
+        float t = progress[i];
+        easedProgress[i] = ((cubic[i] * t + quadratic[i]) * t + linear[i]) * t;
+    }
+    // A finished track ends exactly at its end value, whatever its easing
+    for (size_t i = 0; i < count; i++) {
+        *tracks.targets[i] = progress[i] < 1 ? interpolate(tracks.startValues[i], tracks.endValues[i], easedProgress[i])
+            : tracks.endValues[i];
+    }
+
+    // The progress of the last track moves with it, to be checked in turn
+    for (size_t i = 0; i < tracks.targets.size();) {
+        if (progress[i] < 1) {
+            i++;
+        } else {
+            progress[i] = progress[tracks.targets.size() - 1];
+            remove(tracks, i);
+        }
+    }
+}
+
+template <typename T>
+void removeField(std::vector<T> &fields, size_t index)
+{
+    fields[index] = fields.back();
+    fields.pop_back();
+}
+
+float interpolate(float startValue, float endValue, float t)
+{
+    return startValue * (1 - t) + endValue * t;
+}
+
+Color interpolate(const Color &startColor, const Color &endColor, float t)
+{
+    return Color(interpolateChannel(startColor.getRed(), endColor.getRed(), t),
+        interpolateChannel(startColor.getGreen(), endColor.getGreen(), t),
+        interpolateChannel(startColor.getBlue(), endColor.getBlue(), t),
+        interpolateChannel(startColor.getAlpha(), endColor.getAlpha(), t));
+}
+
+uint8_t interpolateChannel(uint8_t start, uint8_t end, float t)
+{
+    // Easings can overshoot slightly because of rounding
+    return std::min(std::max(start * (1 - t) + end * t + 0.5f, 0.0f), 255.0f);
+}
+
+}
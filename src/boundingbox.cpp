@@ -0,0 +1,65 @@
+
+#include "pinta/boundingbox.h"
+
+#include <limits>
+
+namespace pinta {
+
+BoundingBox::BoundingBox():
+    min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max())
+{
+}
+
+BoundingBox::BoundingBox(const glm::vec2 &min, const glm::vec2 &max):
+    min(min), max(max)
+{
+}
+
+BoundingBox BoundingBox::fromVertices(const std::vector<Vertex> &vertices)
+{
+    BoundingBox box;
+    for (const Vertex &vertex: vertices) {
+        box.merge(glm::vec2(vertex.position[0], vertex.position[1]));
+    }
+    return box;
+}
+
+bool BoundingBox::contains(const glm::vec2 &point) const
+{
+    return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y;
+}
+
+bool BoundingBox::intersects(const BoundingBox &other) const
+{
+    return !isEmpty() && !other.isEmpty() && min.x <= other.max.x && other.min.x <= max.x
+        && min.y <= other.max.y && other.min.y <= max.y;
+}
+
+void BoundingBox::merge(const BoundingBox &other)
+{
+    if (!other.isEmpty()) {
+        merge(other.min);
+        merge(other.max);
+    }
+}
+
+void BoundingBox::merge(const glm::vec2 &point)
+{
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+
+BoundingBox BoundingBox::transform(const glm::vec2 &position, const glm::vec2 &scale) const
+{
+    if (isEmpty()) {
+        return *this;
+    }
+
+    // A negative scale swaps the corners
+    BoundingBox box;
+    box.merge(position + min * scale);
+    box.merge(position + max * scale);
+    return box;
+}
+
+}
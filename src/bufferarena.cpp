@@ -0,0 +1,179 @@
+
+#include "pinta/bufferarena.h"
+#include "pinta/renderererror.h"
+#include "pinta/stats.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace pinta {
+
+BufferArena::BufferArena(GLState &state, GLenum target, GLsizei elementSize, GLsizei initialCapacity, GLsizei pageSize):
+    state(state), target(target), elementSize(elementSize), pageSize(pageSize), capacity(initialCapacity), buffer(0),
+    data(initialCapacity * elementSize), compactable(false)
+{
+    glGenBuffers(1, &buffer);
+    state.bindBuffer(target, buffer);
+    glBufferData(target, capacity * elementSize, nullptr, GL_DYNAMIC_DRAW);
+    freeSlices[0] = capacity;
+}
+
+BufferArena::~BufferArena()
+{
+    state.deleteBuffer(buffer);
+}
+
+GLsizei BufferArena::allocate(GLsizei count)
+{
+    if (count == 0) {
+        return 0;
+    }
+    if (pageSize && count > pageSize) {
+        throw RendererError("slice larger than the buffer page size");
+    }
+
+    GLsizei offset = findSlice(count, capacity);
+    while (offset < 0) {
+        grow(count);
+        offset = findSlice(count, capacity);
+    }
+    take(offset, count);
+    return offset;
+}
+
+void BufferArena::bind() const
+{
+    state.bindBuffer(target, buffer);
+}
+
+void BufferArena::free(GLsizei offset, GLsizei count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    // Merge with the adjacent free slices
+    auto next = freeSlices.lower_bound(offset);
+    if (next != freeSlices.end() && next->first == offset + count) {
+        count += next->second;
+        next = freeSlices.erase(next);
+    }
+    if (next != freeSlices.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += count;
+            compactable = compactable || isFragmented();
+            return;
+        }
+    }
+    freeSlices[offset] = count;
+    compactable = compactable || isFragmented();
+}
+
+bool BufferArena::isFragmented() const
+{
+    // More than the slice at the end of the buffer is free
+    return freeSlices.size() > 1 || (freeSlices.size() == 1 && freeSlices.begin()->first + freeSlices.begin()->second != capacity);
+}
+
+GLsizei BufferArena::relocate(GLsizei offset, GLsizei count)
+{
+    GLsizei newOffset = findSlice(count, offset);
+    if (count == 0 || newOffset < 0) {
+        return offset;
+    }
+
+    take(newOffset, count);
+    std::memmove(data.data() + newOffset * elementSize, data.data() + offset * elementSize, count * elementSize);
+    upload(newOffset, count, nullptr);
+    free(offset, count);
+    return newOffset;
+}
+
+void BufferArena::update(GLsizei offset, GLsizei count, const void *elements)
+{
+    // Upload only the range of bytes that differ from the current contents
+    const uint8_t *source = static_cast<const uint8_t *>(elements);
+    uint8_t *destination = data.data() + offset * elementSize;
+    GLsizei size = count * elementSize;
+    GLsizei first = 0;
+    while (first < size && source[first] == destination[first]) {
+        first++;
+    }
+    if (first == size) {
+        return;
+    }
+    GLsizei last = size;
+    while (source[last - 1] == destination[last - 1]) {
+        last--;
+    }
+
+    std::memcpy(destination + first, source + first, last - first);
+    state.bindBuffer(target, buffer);
+    glBufferSubData(target, offset * elementSize + first, last - first, destination + first);
+    PINTA_COUNT(BUFFER_UPLOADS, 1);
+    PINTA_COUNT(BYTES_UPLOADED, last - first);
+}
+
+void BufferArena::upload(GLsizei offset, GLsizei count, const void *elements)
+{
+    if (count == 0) {
+        return;
+    }
+    if (elements) {
+        std::memcpy(data.data() + offset * elementSize, elements, count * elementSize);
+    }
+    state.bindBuffer(target, buffer);
+    glBufferSubData(target, offset * elementSize, count * elementSize, data.data() + offset * elementSize);
+    PINTA_COUNT(BUFFER_UPLOADS, 1);
+    PINTA_COUNT(BYTES_UPLOADED, count * elementSize);
+}
+
+GLsizei BufferArena::findSlice(GLsizei count, GLsizei limit) const
+{
+    // First fit that starts before limit and does not cross a page boundary
+    for (const auto &slice: freeSlices) {
+        GLsizei offset = slice.first;
+        if (offset >= limit) {
+            break;
+        }
+        if (pageSize && offset % pageSize + count > pageSize) {
+            offset = (offset / pageSize + 1) * pageSize;
+        }
+        if (offset < limit && offset + count <= slice.first + slice.second) {
+            return offset;
+        }
+    }
+    return -1;
+}
+
+void BufferArena::grow(GLsizei count)
+{
+    // Grow geometrically so that the amortized cost of a reallocation stays constant
+    GLsizei oldCapacity = capacity;
+    capacity = std::max(capacity * 2, capacity + count);
+
+    data.resize(capacity * elementSize);
+    state.bindBuffer(target, buffer);
+    glBufferData(target, capacity * elementSize, nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(target, 0, oldCapacity * elementSize, data.data());
+    PINTA_COUNT(FULL_REBUILDS, 1);
+    PINTA_COUNT(BYTES_UPLOADED, oldCapacity * elementSize);
+    free(oldCapacity, capacity - oldCapacity);
+}
+
+void BufferArena::take(GLsizei offset, GLsizei count)
+{
+    auto slice = std::prev(freeSlices.upper_bound(offset));
+    GLsizei sliceOffset = slice->first;
+    GLsizei sliceEnd = slice->first + slice->second;
+    freeSlices.erase(slice);
+    if (offset > sliceOffset) {
+        freeSlices[sliceOffset] = offset - sliceOffset;
+    }
+    if (offset + count < sliceEnd) {
+        freeSlices[offset + count] = sliceEnd - offset - count;
+    }
+}
+
+}
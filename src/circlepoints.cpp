@@ -0,0 +1,141 @@
+
+#include "pinta/circlepoints.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+namespace pinta {
+
+typedef void (*CirclePointsFunction)(float x, float y, float radius, float startAngle, float step, int count,
+    Vertex *vertices);
+
+static void circlePointsFirst(float x, float y, float radius, float startAngle, float step, int count,
+    Vertex *vertices);
+static CirclePointsFunction selectCirclePoints();
+
+// Starts with a function that chooses the implementation, so that nothing
+// runs before main. Threads that race on the first call choose the same.
+static std::atomic<CirclePointsFunction> circlePointsImplementation(circlePointsFirst);
+
+void circlePoints(float x, float y, float radius, float startAngle, float step, int count, Vertex *vertices)
+{
+    circlePointsImplementation.load(std::memory_order_relaxed)(x, y, radius, startAngle, step, count, vertices);
+}
+
+void circlePointsScalar(float x, float y, float radius, float startAngle, float step, int count, Vertex *vertices)
+{
+    for (int i = 0; i < count; i++) {
+        float angle = startAngle + step * i;
+        vertices[i].position[0] = x + std::cos(angle) * radius;
+        vertices[i].position[1] = y + std::sin(angle) * radius;
+    }
+}
+
+void circlePointsFirst(float x, float y, float radius, float startAngle, float step, int count, Vertex *vertices)
+{
+    CirclePointsFunction implementation = selectCirclePoints();
+    circlePointsImplementation.store(implementation, std::memory_order_relaxed);
+    implementation(x, y, radius, startAngle, step, count, vertices);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__) || defined(__ARM_NEON) || defined(__aarch64__))
+
+// The vector kernel is written with the GCC vector extensions, which are
+// lowered to SSE, AVX or NEON depending on the target of the function it is
+// inlined in. Sine and cosine are evaluated with the minimax polynomials of
+// the Cephes library after reducing the angle to [-pi/4, pi/4].
+template <typename Float, typename Int, int N>
+__attribute__((always_inline)) inline void circlePointsVector(float x, float y, float radius, float startAngle,
+    float step, int count, Vertex *vertices)
+{
+    Float lanes;
+    for (int i = 0; i < N; i++) {
+        lanes[i] = i;
+    }
+
+    for (int first = 0; first < count; first += N) {
+        Float angle = startAngle + step * (lanes + static_cast<float>(first));
+
+        // Octant of the angle, rounded to an even number
+        Float absoluteAngle = angle < 0 ? -angle : angle;
+        Int octant = __builtin_convertvector(absoluteAngle * 1.27323954473516f, Int);
+        octant = (octant + 1) & ~1;
+        Float octantAngle = __builtin_convertvector(octant, Float);
+        Float reduced = ((absoluteAngle - octantAngle * 0.78515625f) - octantAngle * 2.4187564849853515625e-4f)
+            - octantAngle * 3.77489497744594108e-8f;
+
+        Float z = reduced * reduced;
+        Float cosine = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z
+            - 0.5f * z + 1.0f;
+        Float sine = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * reduced + reduced;
+
+        // Swap the polynomials and fix their signs depending on the octant
+        Int swap = (octant & 2) != 0;
+        Float s = swap ? cosine : sine;
+        Float c = swap ? sine : cosine;
+        Int negateSine = ((octant & 4) != 0) != (angle < 0);
+        Int negateCosine = ((octant + 2) & 4) != 0;
+        s = negateSine ? -s : s;
+        c = negateCosine ? -c : c;
+
+        Float px = x + c * radius;
+        Float py = y + s * radius;
+        int n = (count - first < N) ? count - first : N;
+        for (int i = 0; i < n; i++) {
+            vertices[first + i].position[0] = px[i];
+            vertices[first + i].position[1] = py[i];
+        }
+    }
+}
+
+typedef float Float4 __attribute__((vector_size(16)));
+typedef int32_t Int4 __attribute__((vector_size(16)));
+
+static void circlePoints4(float x, float y, float radius, float startAngle, float step, int count, Vertex *vertices)
+{
+    circlePointsVector<Float4, Int4, 4>(x, y, radius, startAngle, step, count, vertices);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+typedef float Float8 __attribute__((vector_size(32)));
+typedef int32_t Int8 __attribute__((vector_size(32)));
+
+__attribute__((target("avx2,fma"))) static void circlePoints8(float x, float y, float radius, float startAngle,
+    float step, int count, Vertex *vertices)
+{
+    circlePointsVector<Float8, Int8, 8>(x, y, radius, startAngle, step, count, vertices);
+}
+
+CirclePointsFunction selectCirclePoints()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return circlePoints8;
+    } else if (__builtin_cpu_supports("sse2")) {
+        return circlePoints4;
+    } else {
+        return circlePointsScalar;
+    }
+}
+
+#else
+
+CirclePointsFunction selectCirclePoints()
+{
+    return circlePoints4;
+}
+
+#endif
+
+#else
+
+CirclePointsFunction selectCirclePoints()
+{
+    return circlePointsScalar;
+}
+
+#endif
+
+}
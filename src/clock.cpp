@@ -1,36 +1,83 @@
 
 #include "pinta/clock.h"
+#include "pinta/stats.h"
+
+#include <cerrno>
 
 namespace pinta {
 
 const uint32_t Clock::NANOSECONDS_PER_SECOND = 1000000000;
 const clockid_t Clock::CLOCK = CLOCK_MONOTONIC;
 
-Clock::Clock(double fps):
-    interval(static_cast<uint64_t>(NANOSECONDS_PER_SECOND/fps)), lastTimestamp(0)
+Clock::Clock(double fps, Policy policy):
+    interval(static_cast<uint64_t>(NANOSECONDS_PER_SECOND/fps)), lastTimestamp(0), lastTick(0), delta(0), droppedFrames(0),
+    policy(policy), vsync(false), behind(false)
 {
 }
 
-void Clock::tick()
+double Clock::tick()
 {
     // Obtain the first time reference
+    uint64_t currentTime = now();
     if (lastTimestamp == 0) {
-        struct timespec currentTimeTs;
-        clock_gettime(CLOCK, &currentTimeTs);
-        lastTimestamp = asNanoseconds(currentTimeTs);
+        lastTimestamp = currentTime;
+        lastTick = currentTime;
+    }
+
+    // Compute the next waking up time. The swap already waited for the
+    // vertical sync, so then it is the current time.
+    uint64_t nextTime = vsync ? currentTime : lastTimestamp + interval;
+    // The previous deadline can still be ahead if its sleep was cut short
+    uint64_t elapsed = currentTime > lastTimestamp ? currentTime - lastTimestamp : 0;
+    if (vsync) {
+        // Ticks after the vertical sync jitter around the interval
+        uint64_t intervals = (elapsed + interval / 2) / interval;
+        if (intervals > 1) {
+            PINTA_COUNT(MISSED_DEADLINES, 1);
+            droppedFrames += intervals - 1;
+        }
+    } else if (elapsed > interval) {
+        // The ticks that catch up on a missed deadline are all behind, but
+        // the deadline was only missed once
+        uint64_t passedDeadlines = elapsed / interval;
+        if (!behind || policy != CATCH_UP) {
+            PINTA_COUNT(MISSED_DEADLINES, 1);
+        }
+        if (policy == DROP) {
+            droppedFrames += passedDeadlines;
+            nextTime = lastTimestamp + (passedDeadlines + 1) * interval;
+        } else if (policy == REANCHOR) {
+            droppedFrames += passedDeadlines;
+            nextTime = currentTime;
+        }
     }
 
-    // Compute the next waking up time
-    uint64_t nextTime = lastTimestamp + interval;
-    struct timespec targetTime;
-    targetTime.tv_sec = nextTime / NANOSECONDS_PER_SECOND;
-    targetTime.tv_nsec = nextTime % NANOSECONDS_PER_SECOND;
+    behind = !vsync && elapsed > interval;
 
     // Sleep until next waking up time
-    clock_nanosleep(CLOCK, TIMER_ABSTIME, &targetTime, 0);
+    if (nextTime > currentTime) {
+        struct timespec targetTime;
+        targetTime.tv_sec = nextTime / NANOSECONDS_PER_SECOND;
+        targetTime.tv_nsec = nextTime % NANOSECONDS_PER_SECOND;
+        while (clock_nanosleep(CLOCK, TIMER_ABSTIME, &targetTime, 0) == EINTR) {
+        }
+    }
 
-    // Update the current time
+    // Update the current time, and the time that really passed since the
+    // previous tick
     lastTimestamp = nextTime;
+    currentTime = now();
+    delta = currentTime - lastTick;
+    lastTick = currentTime;
+    PINTA_FRAME_TIME(delta);
+    return getDelta();
+}
+
+uint64_t Clock::now()
+{
+    struct timespec currentTimeTs;
+    clock_gettime(CLOCK, &currentTimeTs);
+    return asNanoseconds(currentTimeTs);
 }
 
 }
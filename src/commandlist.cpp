@@ -0,0 +1,255 @@
+
+#include "pinta/commandlist.h"
+
+#include <utility>
+
+namespace pinta {
+
+CommandList::CommandList():
+    drawListCount(0)
+{
+}
+
+void CommandList::clear()
+{
+    add(CLEAR);
+}
+
+void CommandList::draw(const DrawList &drawList)
+{
+    if (drawListCount == drawLists.size()) {
+        drawLists.push_back(drawList);
+    } else {
+        drawLists[drawListCount] = drawList;
+    }
+    add(DRAW, glm::vec3(0.0, 0.0, 0.0), drawListCount++);
+}
+
+void CommandList::draw(DrawList &&drawList)
+{
+    if (drawListCount == drawLists.size()) {
+        drawLists.push_back(DrawList());
+    }
+    std::swap(drawLists[drawListCount], drawList);
+    add(DRAW, glm::vec3(0.0, 0.0, 0.0), drawListCount++);
+}
+
+void CommandList::draw(Scene &scene)
+{
+    add(DRAW_SCENE);
+    commands.back().scene = &scene;
+}
+
+void CommandList::draw(const MeshStore &store, const MeshHandle *handles, size_t count)
+{
+    add(DRAW_STORE);
+    commands.back().store = &store;
+    commands.back().first = this->handles.size();
+    commands.back().count = count;
+    this->handles.insert(this->handles.end(), handles, handles + count);
+}
+
+void CommandList::draw(const MeshBatch &batch)
+{
+    add(DRAW_BATCH);
+    commands.back().batch = &batch;
+}
+
+void CommandList::draw(const SdfShape *shapes, size_t count)
+{
+    add(DRAW_SHAPES);
+    commands.back().first = this->shapes.size();
+    commands.back().count = count;
+    this->shapes.insert(this->shapes.end(), shapes, shapes + count);
+}
+
+void CommandList::keep(std::shared_ptr<const Mesh> mesh)
+{
+    meshes.push_back(std::move(mesh));
+}
+
+void CommandList::popClip()
+{
+    add(POP_CLIP);
+}
+
+void CommandList::popTransform()
+{
+    add(POP_TRANSFORM);
+}
+
+void CommandList::pushClip(const BoundingBox &area)
+{
+    add(PUSH_CLIP);
+    commands.back().area = area;
+}
+
+void CommandList::pushClip(const Mesh *mask)
+{
+    add(PUSH_CLIP);
+    commands.back().mask = mask;
+}
+
+void CommandList::pushTransform()
+{
+    add(PUSH_TRANSFORM);
+}
+
+void CommandList::release(const Mesh *mesh)
+{
+    add(RELEASE_MESH);
+    commands.back().mask = mesh;
+}
+
+void CommandList::release(const MeshStore *store)
+{
+    add(RELEASE_STORE);
+    commands.back().store = store;
+}
+
+void CommandList::release(const MeshBatch *batch)
+{
+    add(RELEASE_BATCH);
+    commands.back().batch = batch;
+}
+
+void CommandList::replay(Renderer &renderer) const
+{
+    for (const Command &command: commands) {
+        switch (command.type) {
+        case CLEAR:
+            renderer.clear();
+            break;
+        case DRAW:
+            renderer.draw(drawLists[command.drawList]);
+            break;
+        case DRAW_BATCH:
+            renderer.draw(*command.batch);
+            break;
+        case DRAW_SCENE:
+            renderer.draw(*command.scene);
+            break;
+        case DRAW_SHAPES:
+            renderer.draw(shapes.data() + command.first, command.count);
+            break;
+        case DRAW_STORE:
+            renderer.draw(*command.store, handles.data() + command.first, command.count);
+            break;
+        case POP_CLIP:
+            renderer.popClip();
+            break;
+        case POP_TRANSFORM:
+            renderer.popTransform();
+            break;
+        case PUSH_CLIP:
+            if (command.mask) {
+                renderer.pushClip(command.mask);
+            } else {
+                renderer.pushClip(command.area);
+            }
+            break;
+        case PUSH_TRANSFORM:
+            renderer.pushTransform();
+            break;
+        case RELEASE_BATCH:
+            renderer.release(command.batch);
+            break;
+        case RELEASE_MESH:
+            renderer.release(command.mask);
+            break;
+        case RELEASE_STORE:
+            renderer.release(command.store);
+            break;
+        case RESET_TRANSFORMATIONS:
+            renderer.resetTransformations();
+            break;
+        case ROTATE:
+            renderer.rotate(command.value.x);
+            break;
+        case SCALE:
+            renderer.scale(glm::vec2(command.value.x, command.value.y));
+            break;
+        case SET_BACKGROUND_COLOR:
+            renderer.setBackgroundColor(command.value);
+            break;
+        case SET_DAMAGE:
+            renderer.setDamage(command.area);
+            break;
+        case SET_TIME:
+            renderer.setTime(command.value.x);
+            break;
+        case TRANSLATE:
+            renderer.translate(glm::vec2(command.value.x, command.value.y));
+            break;
+        }
+    }
+}
+
+void CommandList::reset()
+{
+    commands.clear();
+    for (size_t i = 0; i < drawListCount; i++) {
+        drawLists[i].clear();
+    }
+    drawListCount = 0;
+    meshes.clear();
+    shapes.clear();
+    handles.clear();
+}
+
+void CommandList::resetTransformations()
+{
+    add(RESET_TRANSFORMATIONS);
+}
+
+void CommandList::rotate(float angle)
+{
+    add(ROTATE, glm::vec3(angle, 0.0, 0.0));
+}
+
+void CommandList::scale(const glm::vec2 &scaleFactor)
+{
+    add(SCALE, glm::vec3(scaleFactor.x, scaleFactor.y, 0.0));
+}
+
+void CommandList::setBackgroundColor(const glm::vec3 &color)
+{
+    add(SET_BACKGROUND_COLOR, color);
+}
+
+void CommandList::setDamage(const BoundingBox &area)
+{
+    // Before everything else, as it is usually known once the list is done
+    add(SET_DAMAGE);
+    Command command = commands.back();
+    commands.pop_back();
+    command.area = area;
+    commands.insert(commands.begin(), command);
+}
+
+void CommandList::setTime(float time)
+{
+    add(SET_TIME, glm::vec3(time, 0.0, 0.0));
+}
+
+void CommandList::translate(const glm::vec2 &position)
+{
+    add(TRANSLATE, glm::vec3(position.x, position.y, 0.0));
+}
+
+void CommandList::add(Type type, const glm::vec3 &value, size_t drawList)
+{
+    Command command;
+    command.type = type;
+    command.value = value;
+    command.drawList = drawList;
+    command.mask = nullptr;
+    command.batch = nullptr;
+    command.store = nullptr;
+    command.scene = nullptr;
+    command.first = 0;
+    command.count = 0;
+    commands.push_back(command);
+}
+
+}
@@ -0,0 +1,243 @@
+
+#include "pinta/damagetracker.h"
+#include "pinta/stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pinta {
+
+static uint64_t hash(uint64_t seed, const void *data, size_t size);
+static uint64_t hash(uint64_t seed, const Transform2D &transform);
+static BoundingBox intersect(const BoundingBox &a, const BoundingBox &b);
+
+DamageTracker::DamageTracker(int width, int height):
+    width(width), height(height), projection(2.0 / width, 0.0, 0.0, 0.0, 2.0 / height, 0.0), time(0.0),
+    backgroundColor(0.0, 0.0, 0.0), invalid(true)
+{
+}
+
+const BoundingBox & DamageTracker::update(const CommandList &commands)
+{
+    // Follow the state of the renderer through the commands, which also
+    // keeps what the previous frames left
+    Clip window = {BoundingBox(glm::vec2(0.0, 0.0), glm::vec2(width, height)), 0};
+    records.clear();
+    for (const CommandList::Command &command: commands.commands) {
+        glm::vec2 value(command.value.x, command.value.y);
+        switch (command.type) {
+        case CommandList::CLEAR:
+            records.clear();
+            clips.clear();
+            break;
+        case CommandList::DRAW:
+            for (const DrawItem &item: commands.drawLists[command.drawList].getItems()) {
+                record(item, projection * transformation, clips.empty() ? window : clips.back(), command.drawList);
+            }
+            break;
+        case CommandList::DRAW_BATCH:
+        case CommandList::DRAW_SCENE:
+        case CommandList::DRAW_STORE:
+            invalid = true;
+            break;
+        case CommandList::DRAW_SHAPES:
+            for (size_t i = command.first; i < command.first + command.count; i++) {
+                record(commands.shapes[i], projection * transformation, clips.empty() ? window : clips.back(), i);
+            }
+            break;
+        case CommandList::POP_CLIP:
+            if (!clips.empty()) {
+                clips.pop_back();
+            }
+            break;
+        case CommandList::POP_TRANSFORM:
+            if (!transformStack.empty()) {
+                transformation = transformStack.back();
+                transformStack.pop_back();
+            }
+            break;
+        case CommandList::PUSH_CLIP: {
+            // Rotated rectangles and masks are taken as their bounds
+            Transform2D modelview = projection * transformation;
+            const Clip &outer = clips.empty() ? window : clips.back();
+            Clip clip;
+            clip.bounds = intersect(getWindowBounds(command.mask ? command.mask->getBounds() : command.area, modelview),
+                outer.bounds);
+            clip.key = hash(outer.key, modelview);
+            if (command.mask) {
+                unsigned int generation = command.mask->getGeneration();
+                clip.key = hash(hash(clip.key, &command.mask, sizeof(command.mask)), &generation, sizeof(generation));
+            } else {
+                glm::vec2 corners[2] = {command.area.getMin(), command.area.getMax()};
+                clip.key = hash(clip.key, corners, sizeof(corners));
+            }
+            clips.push_back(clip);
+            break;
+        }
+        case CommandList::PUSH_TRANSFORM:
+            transformStack.push_back(transformation);
+            break;
+        case CommandList::RELEASE_BATCH:
+        case CommandList::RELEASE_MESH:
+        case CommandList::RELEASE_STORE:
+            break;
+        case CommandList::RESET_TRANSFORMATIONS:
+            transformation = Transform2D();
+            break;
+        case CommandList::ROTATE:
+            transformation.rotate(command.value.x);
+            break;
+        case CommandList::SCALE:
+            transformation.scale(value);
+            break;
+        case CommandList::SET_BACKGROUND_COLOR:
+            // The background is behind everything
+            invalid = invalid || command.value != backgroundColor;
+            backgroundColor = command.value;
+            break;
+        case CommandList::SET_DAMAGE:
+            break;
+        case CommandList::SET_TIME:
+            time = command.value.x;
+            break;
+        case CommandList::TRANSLATE:
+            transformation.translate(value);
+            break;
+        }
+    }
+
+    // The records that are only in one of the frames are the changes
+    std::sort(records.begin(), records.end(), [](const Record &a, const Record &b) {return a.key < b.key;});
+    damage = BoundingBox();
+    if (invalid) {
+        damage = window.bounds;
+        invalid = false;
+    } else {
+        auto current = records.begin();
+        auto previous = previousRecords.begin();
+        while (current != records.end() || previous != previousRecords.end()) {
+            if (previous == previousRecords.end() || (current != records.end() && current->key < previous->key)) {
+                damage.merge(current++->bounds);
+            } else if (current == records.end() || previous->key < current->key) {
+                damage.merge(previous++->bounds);
+            } else {
+                ++current;
+                ++previous;
+            }
+        }
+    }
+    std::swap(records, previousRecords);
+    if (!damage.isEmpty()) {
+        PINTA_COUNT(DAMAGED_PIXELS, (damage.getMax().x - damage.getMin().x) * (damage.getMax().y - damage.getMin().y));
+    }
+    return damage;
+}
+
+BoundingBox DamageTracker::getWindowBounds(const BoundingBox &bounds, const Transform2D &transform) const
+{
+    if (bounds.isEmpty()) {
+        return bounds;
+    }
+
+    BoundingBox windowBounds;
+    for (const glm::vec2 &corner: {bounds.getMin(), bounds.getMax(), glm::vec2(bounds.getMin().x, bounds.getMax().y),
+            glm::vec2(bounds.getMax().x, bounds.getMin().y)}) {
+        glm::vec2 position = transform.apply(corner);
+        windowBounds.merge(glm::vec2((position.x + 1.0) * width / 2.0, (position.y + 1.0) * height / 2.0));
+    }
+    // Whole pixels, with one more around for the lines and points that are
+    // wider than their vertices
+    return BoundingBox(glm::vec2(std::floor(windowBounds.getMin().x) - 1.0, std::floor(windowBounds.getMin().y) - 1.0),
+        glm::vec2(std::ceil(windowBounds.getMax().x) + 1.0, std::ceil(windowBounds.getMax().y) + 1.0));
+}
+
+void DamageTracker::record(const DrawItem &item, const Transform2D &modelview, const Clip &clip, size_t drawList)
+{
+    // The same level of detail as the renderer
+    const Mesh *mesh = item.shape ? item.shape->getMesh(modelview, item.scale, width, height) : item.mesh;
+    BoundingBox bounds = mesh->getBounds();
+    if (item.animation) {
+        // The animation moves the item between its keyframes
+        const glm::vec4 *uniforms = item.animation->getUniforms();
+        BoundingBox animated = bounds.transform(glm::vec2(uniforms[3].x, uniforms[3].y), glm::vec2(uniforms[4].x, uniforms[4].y));
+        animated.merge(bounds.transform(glm::vec2(uniforms[3].z, uniforms[3].w), glm::vec2(uniforms[4].z, uniforms[4].w)));
+        bounds = animated;
+    }
+
+    Record record;
+    record.bounds = intersect(getWindowBounds(bounds.transform(item.position, item.scale), modelview), clip.bounds);
+    if (record.bounds.isEmpty()) {
+        return;
+    }
+
+    // Everything that changes the pixels of the item is in its key
+    unsigned int generation = mesh->getGeneration();
+    uint8_t color[4] = {item.color.getRed(), item.color.getGreen(), item.color.getBlue(), item.color.getAlpha()};
+    int state = item.state.getSortKey();
+    record.key = hash(clip.key, modelview);
+    record.key = hash(record.key, &mesh, sizeof(mesh));
+    record.key = hash(record.key, &generation, sizeof(generation));
+    record.key = hash(record.key, &item.position, sizeof(item.position));
+    record.key = hash(record.key, &item.scale, sizeof(item.scale));
+    record.key = hash(record.key, color, sizeof(color));
+    record.key = hash(record.key, &state, sizeof(state));
+    record.key = hash(record.key, &item.layer, sizeof(item.layer));
+    record.key = hash(record.key, &drawList, sizeof(drawList));
+    if (item.animation) {
+        record.key = hash(record.key, item.animation->getUniforms(), ShaderAnimation::UNIFORMS * sizeof(glm::vec4));
+        record.key = hash(record.key, &time, sizeof(time));
+    }
+    records.push_back(record);
+}
+
+void DamageTracker::record(const SdfShape &shape, const Transform2D &modelview, const Clip &clip, size_t index)
+{
+    // The smooth edge is inside the pixel around the window bounds
+    glm::vec2 halfSize(std::abs(shape.width) / 2, std::abs(shape.height) / 2);
+    Record record;
+    record.bounds = intersect(getWindowBounds(BoundingBox(shape.position - halfSize, shape.position + halfSize), modelview),
+        clip.bounds);
+    if (record.bounds.isEmpty()) {
+        return;
+    }
+
+    float values[6] = {shape.position.x, shape.position.y, shape.width, shape.height, shape.cornerRadius, shape.thickness};
+    uint8_t color[4] = {shape.color.getRed(), shape.color.getGreen(), shape.color.getBlue(), shape.color.getAlpha()};
+    record.key = hash(clip.key, modelview);
+    record.key = hash(record.key, values, sizeof(values));
+    record.key = hash(record.key, color, sizeof(color));
+    record.key = hash(record.key, &index, sizeof(index));
+    records.push_back(record);
+}
+
+uint64_t hash(uint64_t seed, const void *data, size_t size)
+{
+    // FNV-1a
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint64_t value = seed ^ 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        value = (value ^ bytes[i]) * 1099511628211ull;
+    }
+    return value;
+}
+
+uint64_t hash(uint64_t seed, const Transform2D &transform)
+{
+    float values[6];
+    for (int i = 0; i < 6; i++) {
+        values[i] = transform.get(i / 3, i % 3);
+    }
+    return hash(seed, values, sizeof(values));
+}
+
+BoundingBox intersect(const BoundingBox &a, const BoundingBox &b)
+{
+    glm::vec2 min(std::max(a.getMin().x, b.getMin().x), std::max(a.getMin().y, b.getMin().y));
+    glm::vec2 max(std::min(a.getMax().x, b.getMax().x), std::min(a.getMax().y, b.getMax().y));
+    if (a.isEmpty() || b.isEmpty() || min.x > max.x || min.y > max.y) {
+        return BoundingBox();
+    }
+    return BoundingBox(min, max);
+}
+
+}
@@ -1,11 +1,22 @@
 
 #include "pinta/display.h"
 #include "pinta/displayerror.h"
+#include "pinta/extensions.h"
+#include "pinta/scopedphase.h"
+
+#include <cmath>
+#ifdef PINTA_HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
 namespace pinta {
 
+static bool preserveContents();
+static bool swapWithDamage(const BoundingBox &damage);
+
 Display::Display(int width, int height, const char *title):
-    width(width), height(height)
+    width(width), height(height), vsync(false), preserved(false)
 {
     init(title);
 }
@@ -16,24 +27,29 @@ Display::~Display()
     SDL_Quit();
 }
 
+void Display::makeCurrent(bool current)
+{
+    if (SDL_GL_MakeCurrent(window, current ? context : nullptr) < 0) {
+        throw DisplayError(SDL_GetError());
+    }
+}
+
 void Display::swap()
 {
+    PINTA_PHASE(SWAP);
     SDL_GL_SwapWindow(window);
 }
 
-void Display::init(const char *title)
+void Display::swap(const BoundingBox &damage)
 {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        throw DisplayError(SDL_GetError());
+    PINTA_PHASE(SWAP);
+    if (!swapWithDamage(damage)) {
+        SDL_GL_SwapWindow(window);
     }
+}
 
-    //SDL_ShowCursor(SDL_DISABLE);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
-    SDL_GL_SetSwapInterval(1);
-    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-    SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 1);
-
+bool Display::createWindow(const char *title)
+{
     window = SDL_CreateWindow(
         title,
         SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
@@ -41,11 +57,98 @@ void Display::init(const char *title)
         SDL_WINDOW_SHOWN | SDL_WINDOW_OPENGL
         );
     if (!window)
+        return false;
+
+    context = SDL_GL_CreateContext(window);
+    if (!context) {
+        SDL_DestroyWindow(window);
+        window = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void Display::init(const char *title)
+{
+#ifdef PINTA_HAVE_EGL
+    // An EGL surface on X11 too, whose contents can be kept between frames
+    SDL_SetHint("SDL_VIDEO_X11_FORCE_EGL", "1");
+#endif
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         throw DisplayError(SDL_GetError());
+    }
+
+    //SDL_ShowCursor(SDL_DISABLE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
 
-    SDL_GLContext context = SDL_GL_CreateContext(window);
-    if (!context)
+    bool created = createWindow(title);
+#ifdef PINTA_HAVE_EGL
+    if (!created) {
+        // Where X11 has no EGL, or no ES context through it, SDL uses GLX
+        SDL_SetHint("SDL_VIDEO_X11_FORCE_EGL", "0");
+        created = createWindow(title);
+    }
+#endif
+    if (!created)
         throw DisplayError(SDL_GetError());
+
+    // The swap interval applies to the current context, so it can only be set
+    // once there is one
+    vsync = SDL_GL_SetSwapInterval(1) == 0;
+    preserved = preserveContents();
+}
+
+bool preserveContents()
+{
+#ifdef PINTA_HAVE_EGL
+    // SDL does not expose its EGL surface, but it is the current one
+    EGLDisplay display = eglGetCurrentDisplay();
+    EGLSurface surface = eglGetCurrentSurface(EGL_DRAW);
+    EGLint behavior = EGL_BUFFER_DESTROYED;
+    return display != EGL_NO_DISPLAY && surface != EGL_NO_SURFACE
+        && eglSurfaceAttrib(display, surface, EGL_SWAP_BEHAVIOR, EGL_BUFFER_PRESERVED)
+        && eglQuerySurface(display, surface, EGL_SWAP_BEHAVIOR, &behavior) && behavior == EGL_BUFFER_PRESERVED;
+#else
+    return false;
+#endif
+}
+
+bool swapWithDamage(const BoundingBox &damage)
+{
+#ifdef PINTA_HAVE_EGL
+    EGLDisplay display = eglGetCurrentDisplay();
+    EGLSurface surface = eglGetCurrentSurface(EGL_DRAW);
+    if (display == EGL_NO_DISPLAY || surface == EGL_NO_SURFACE || damage.isEmpty()) {
+        return false;
+    }
+    // eglGetProcAddress may return functions the display doesn't support
+    static PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC swapBuffersWithDamage = [display]() {
+        const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+        void (*function)() = nullptr;
+        if (hasExtension(extensions, "EGL_KHR_swap_buffers_with_damage")) {
+            function = eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+        } else if (hasExtension(extensions, "EGL_EXT_swap_buffers_with_damage")) {
+            function = eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+        }
+        return reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(function);
+    }();
+    if (!swapBuffersWithDamage) {
+        return false;
+    }
+    // A rectangle from the bottom left corner, as the damage
+    EGLint rectangle[4] = {
+        EGLint(std::floor(damage.getMin().x)), EGLint(std::floor(damage.getMin().y)),
+        EGLint(std::ceil(damage.getMax().x) - std::floor(damage.getMin().x)),
+        EGLint(std::ceil(damage.getMax().y) - std::floor(damage.getMin().y))
+    };
+    return swapBuffersWithDamage(display, surface, rectangle, 1);
+#else
+    return false;
+#endif
 }
 
 }
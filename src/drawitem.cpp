@@ -0,0 +1,48 @@
+
+#include "pinta/drawitem.h"
+
+#include <functional>
+
+namespace pinta {
+
+static uint32_t packColor(const Color &color);
+
+DrawItem::DrawItem(const Mesh *mesh, const glm::vec2 &position, const glm::vec2 &scale, const DrawState &state, int layer,
+        const Color &color, const ShaderAnimation *animation):
+    mesh(mesh), shape(nullptr), position(position), scale(scale), state(state), layer(layer), color(color),
+    animation(animation)
+{
+
+}
+
+DrawItem::DrawItem(const LodShape *shape, const glm::vec2 &position, const glm::vec2 &scale, const DrawState &state,
+        int layer, const Color &color, const ShaderAnimation *animation):
+    mesh(nullptr), shape(shape), position(position), scale(scale), state(state), layer(layer), color(color),
+    animation(animation)
+{
+
+}
+
+bool DrawItem::isDrawnBefore(const DrawItem &other) const
+{
+    if (layer != other.layer) {
+        return layer < other.layer;
+    } else if (state != other.state) {
+        return state.getSortKey() < other.state.getSortKey();
+    } else if (position != other.position) {
+        return position.x < other.position.x || (position.x == other.position.x && position.y < other.position.y);
+    } else if (scale != other.scale) {
+        return scale.x < other.scale.x || (scale.x == other.scale.x && scale.y < other.scale.y);
+    } else if (color != other.color) {
+        return packColor(color) < packColor(other.color);
+    } else {
+        return std::less<const ShaderAnimation *>()(animation, other.animation);
+    }
+}
+
+uint32_t packColor(const Color &color)
+{
+    return (color.getRed() << 24) | (color.getGreen() << 16) | (color.getBlue() << 8) | color.getAlpha();
+}
+
+}
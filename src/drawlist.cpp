@@ -0,0 +1,28 @@
+
+#include "pinta/drawlist.h"
+
+namespace pinta {
+
+DrawList::DrawList()
+{
+
+}
+
+void DrawList::add(const Mesh *mesh, const glm::vec2 &position, const glm::vec2 &scale, const DrawState &state, int layer,
+    const Color &color, const ShaderAnimation *animation)
+{
+    items.push_back(DrawItem(mesh, position, scale, state, layer, color, animation));
+}
+
+void DrawList::add(const LodShape *shape, const glm::vec2 &position, const glm::vec2 &scale, const DrawState &state,
+    int layer, const Color &color, const ShaderAnimation *animation)
+{
+    items.push_back(DrawItem(shape, position, scale, state, layer, color, animation));
+}
+
+void DrawList::clear()
+{
+    items.clear();
+}
+
+}
@@ -0,0 +1,23 @@
+
+#include "pinta/drawstate.h"
+
+namespace pinta {
+
+DrawState::DrawState(bool stencilTest, bool updateStencil, bool updateColor):
+    stencilTest(stencilTest), updateStencil(updateStencil), updateColor(updateColor)
+{
+
+}
+
+bool DrawState::operator==(const DrawState &other) const
+{
+    return stencilTest == other.stencilTest && updateStencil == other.updateStencil && updateColor == other.updateColor;
+}
+
+int DrawState::getSortKey() const
+{
+    // Masks that write the stencil go before the items that are tested against it
+    return (updateStencil ? 0 : 4) + (stencilTest ? 2 : 0) + (updateColor ? 1 : 0);
+}
+
+}
@@ -0,0 +1,19 @@
+#include "pinta/extensions.h"
+
+#include <cstring>
+
+namespace pinta {
+
+bool hasExtension(const char *extensions, const char *name)
+{
+    // A name can also be the start of a longer one
+    size_t length = std::strlen(name);
+    for (const char *found = extensions ? std::strstr(extensions, name) : nullptr; found; found = std::strstr(found + length, name)) {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
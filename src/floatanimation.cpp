@@ -1,11 +0,0 @@
-#include "pinta/floatanimation.h"
-
-namespace pinta {
-
-FloatAnimation::FloatAnimation(float startValue, float endValue, float time, float ticksPerSecond):
-    startValue(startValue), endValue(endValue), time(time), ticksPerSecond(ticksPerSecond)
-{
-
-}
-
-}
\ No newline at end of file
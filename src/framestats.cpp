@@ -0,0 +1,46 @@
+
+#include "pinta/framestats.h"
+
+namespace pinta {
+
+FrameStats::FrameStats()
+{
+    clear();
+}
+
+void FrameStats::add(const FrameStats &other)
+{
+    for (int counter = 0; counter < COUNTERS; counter++) {
+        counters[counter] += other.counters[counter];
+    }
+    for (int phase = 0; phase < PHASES; phase++) {
+        phaseTimes[phase] += other.phaseTimes[phase];
+    }
+}
+
+void FrameStats::clear()
+{
+    for (int counter = 0; counter < COUNTERS; counter++) {
+        counters[counter] = 0;
+    }
+    for (int phase = 0; phase < PHASES; phase++) {
+        phaseTimes[phase] = 0;
+    }
+}
+
+const char * FrameStats::getCounterName(Counter counter)
+{
+    static const char *names[COUNTERS] = {
+        "draw_calls", "buffer_uploads", "bytes_uploaded", "full_rebuilds", "uniform_changes", "state_changes",
+        "missed_deadlines", "elided_calls", "damaged_pixels"
+    };
+    return names[counter];
+}
+
+const char * FrameStats::getPhaseName(Phase phase)
+{
+    static const char *names[PHASES] = {"tessellate", "upload", "submit", "swap"};
+    return names[phase];
+}
+
+}
@@ -0,0 +1,260 @@
+
+#include "pinta/glstate.h"
+#include "pinta/stats.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace pinta {
+
+const int GLState::MAX_ATTRIBUTES;
+// Names and values that GL never uses, for the state that is not known
+const GLuint GLState::UNKNOWN = ~0u;
+
+GLState::GLState():
+    elidedCalls(0)
+{
+    reset();
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+    GLuint &bound = target == GL_ARRAY_BUFFER ? arrayBuffer : elementArrayBuffer;
+    if (bound == buffer) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return;
+    }
+    glBindBuffer(target, buffer);
+    bound = buffer;
+}
+
+void GLState::colorMask(bool update)
+{
+    if (colorMaskEnabled == update) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return;
+    }
+    glColorMask(update, update, update, update);
+    colorMaskEnabled = update;
+    PINTA_COUNT(STATE_CHANGES, 1);
+}
+
+void GLState::deleteBuffer(GLuint buffer)
+{
+    // Deleting a bound buffer binds zero
+    glDeleteBuffers(1, &buffer);
+    if (arrayBuffer == buffer) {
+        arrayBuffer = 0;
+    }
+    if (elementArrayBuffer == buffer) {
+        elementArrayBuffer = 0;
+    }
+    // The attributes that pointed into it must be set again, even if a new
+    // buffer gets the same name
+    for (Attribute &attribute: attributes) {
+        if (attribute.buffer == buffer) {
+            attribute.buffer = UNKNOWN;
+        }
+    }
+}
+
+void GLState::enable(GLenum capability, bool enable)
+{
+    int *enabled = capability == GL_STENCIL_TEST ? &stencilTest : capability == GL_SCISSOR_TEST ? &scissorTest
+        : capability == GL_BLEND ? &blend : nullptr;
+    if (enabled && *enabled == enable) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return;
+    }
+    if (enable) {
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+    if (enabled) {
+        *enabled = enable;
+    }
+    PINTA_COUNT(STATE_CHANGES, 1);
+}
+
+void GLState::reset()
+{
+    program = UNKNOWN;
+    arrayBuffer = UNKNOWN;
+    elementArrayBuffer = UNKNOWN;
+    for (Attribute &attribute: attributes) {
+        attribute.enabled = -1;
+        attribute.buffer = UNKNOWN;
+        attribute.value[0] = NAN;
+    }
+    blend = -1;
+    scissorTest = -1;
+    scissorBox[2] = -1;
+    stencilTest = -1;
+    stencilFunction = UNKNOWN;
+    stencilOps[0] = UNKNOWN;
+    stencilWrites = UNKNOWN;
+    colorMaskEnabled = -1;
+    uniforms.clear();
+}
+
+void GLState::scissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (scissorBox[0] == x && scissorBox[1] == y && scissorBox[2] == width && scissorBox[3] == height) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return;
+    }
+    glScissor(x, y, width, height);
+    scissorBox[0] = x;
+    scissorBox[1] = y;
+    scissorBox[2] = width;
+    scissorBox[3] = height;
+    PINTA_COUNT(STATE_CHANGES, 1);
+}
+
+void GLState::stencilFunc(GLenum function, GLint reference, GLuint mask)
+{
+    if (stencilFunction == function && stencilReference == reference && stencilMask == mask) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return;
+    }
+    glStencilFunc(function, reference, mask);
+    stencilFunction = function;
+    stencilReference = reference;
+    stencilMask = mask;
+    PINTA_COUNT(STATE_CHANGES, 1);
+}
+
+void GLState::stencilOp(GLenum fail, GLenum depthFail, GLenum pass)
+{
+    if (stencilOps[0] == fail && stencilOps[1] == depthFail && stencilOps[2] == pass) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return;
+    }
+    glStencilOp(fail, depthFail, pass);
+    stencilOps[0] = fail;
+    stencilOps[1] = depthFail;
+    stencilOps[2] = pass;
+    PINTA_COUNT(STATE_CHANGES, 1);
+}
+
+void GLState::stencilWriteMask(GLuint mask)
+{
+    if (stencilWrites == mask) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return;
+    }
+    glStencilMask(mask);
+    stencilWrites = mask;
+    PINTA_COUNT(STATE_CHANGES, 1);
+}
+
+void GLState::uniform(GLint location, GLfloat value)
+{
+    if (changeUniform(location, 1, &value)) {
+        glUniform1f(location, value);
+    }
+}
+
+void GLState::uniform(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+    GLfloat values[4] = {x, y, z, w};
+    if (changeUniform(location, 4, values)) {
+        glUniform4f(location, x, y, z, w);
+    }
+}
+
+void GLState::uniformVectors(GLint location, GLsizei count, const GLfloat *vectors)
+{
+    if (changeUniform(location, count * 4, vectors)) {
+        glUniform4fv(location, count, vectors);
+    }
+}
+
+void GLState::useProgram(GLuint program)
+{
+    if (this->program == program) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return;
+    }
+    glUseProgram(program);
+    this->program = program;
+    PINTA_COUNT(STATE_CHANGES, 1);
+}
+
+void GLState::vertexAttrib(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+    // The current value of an attribute only matters while its array is disabled
+    GLfloat *value = attributes[index].value;
+    if (value[0] == x && value[1] == y && value[2] == z && value[3] == w) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return;
+    }
+    glVertexAttrib4f(index, x, y, z, w);
+    value[0] = x;
+    value[1] = y;
+    value[2] = z;
+    value[3] = w;
+    PINTA_COUNT(UNIFORM_CHANGES, 1);
+}
+
+void GLState::vertexAttribArray(GLuint index, bool enable)
+{
+    if (attributes[index].enabled == enable) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return;
+    }
+    if (enable) {
+        glEnableVertexAttribArray(index);
+    } else {
+        glDisableVertexAttribArray(index);
+    }
+    attributes[index].enabled = enable;
+    PINTA_COUNT(STATE_CHANGES, 1);
+}
+
+void GLState::vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+    const void *pointer)
+{
+    // The pointer refers to the buffer bound when it is set
+    Attribute &attribute = attributes[index];
+    if (attribute.buffer == arrayBuffer && attribute.size == size && attribute.type == type
+            && attribute.normalized == normalized && attribute.stride == stride && attribute.pointer == pointer) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return;
+    }
+    glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+    attribute.buffer = arrayBuffer;
+    attribute.size = size;
+    attribute.type = type;
+    attribute.normalized = normalized;
+    attribute.stride = stride;
+    attribute.pointer = pointer;
+}
+
+bool GLState::changeUniform(GLint location, GLsizei size, const GLfloat *values)
+{
+    // Uniforms belong to the program in use
+    std::vector<GLfloat> &current = uniforms[static_cast<uint64_t>(program) << 32 | static_cast<uint32_t>(location)];
+    if (current.size() == static_cast<size_t>(size) && std::memcmp(current.data(), values, size * sizeof(GLfloat)) == 0) {
+        elidedCalls++;
+        PINTA_COUNT(ELIDED_CALLS, 1);
+        return false;
+    }
+    current.assign(values, values + size);
+    PINTA_COUNT(UNIFORM_CHANGES, 1);
+    return true;
+}
+
+}
@@ -0,0 +1,113 @@
+
+#include "pinta/indextable.h"
+
+#include <cstdint>
+
+namespace pinta {
+
+const size_t IndexTable::NONE = static_cast<size_t>(-1);
+
+IndexTable::IndexTable():
+    size(0)
+{
+}
+
+void IndexTable::clear()
+{
+    entries.assign(entries.size(), Entry{nullptr, 0});
+    size = 0;
+}
+
+void IndexTable::erase(const void *key)
+{
+    if (entries.empty()) {
+        return;
+    }
+
+    size_t mask = entries.size() - 1;
+    size_t slot = getSlot(key);
+    while (entries[slot].key != key) {
+        if (!entries[slot].key) {
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    // Move back the entries after it that would not be found past the free
+    // entry otherwise
+    for (size_t next = (slot + 1) & mask; entries[next].key; next = (next + 1) & mask) {
+        size_t home = getSlot(entries[next].key);
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            entries[slot] = entries[next];
+            slot = next;
+        }
+    }
+    entries[slot].key = nullptr;
+    size--;
+}
+
+size_t IndexTable::find(const void *key) const
+{
+    if (entries.empty()) {
+        return NONE;
+    }
+
+    size_t mask = entries.size() - 1;
+    for (size_t slot = getSlot(key); entries[slot].key; slot = (slot + 1) & mask) {
+        if (entries[slot].key == key) {
+            return entries[slot].index;
+        }
+    }
+    return NONE;
+}
+
+void IndexTable::insert(const void *key, size_t index)
+{
+    if ((size + 1) * 2 > entries.size()) {
+        rehash(entries.empty() ? 16 : entries.size() * 2);
+    }
+
+    size_t mask = entries.size() - 1;
+    size_t slot = getSlot(key);
+    while (entries[slot].key && entries[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+    size += !entries[slot].key;
+    entries[slot] = Entry{key, index};
+}
+
+void IndexTable::reserve(size_t count)
+{
+    size_t capacity = entries.empty() ? 16 : entries.size();
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+    if (capacity > entries.size()) {
+        rehash(capacity);
+    }
+}
+
+size_t IndexTable::getSlot(const void *key) const
+{
+    // Fibonacci hashing, since the low bits of pointers are mostly the same
+    uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key)) * 0x9e3779b97f4a7c15ull;
+    return static_cast<size_t>(hash >> 32 ^ hash) & (entries.size() - 1);
+}
+
+void IndexTable::rehash(size_t capacity)
+{
+    std::vector<Entry> oldEntries(capacity, Entry{nullptr, 0});
+    oldEntries.swap(entries);
+    size_t mask = capacity - 1;
+    for (const Entry &entry: oldEntries) {
+        if (entry.key) {
+            size_t slot = getSlot(entry.key);
+            while (entries[slot].key) {
+                slot = (slot + 1) & mask;
+            }
+            entries[slot] = entry;
+        }
+    }
+}
+
+}
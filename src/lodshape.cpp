@@ -0,0 +1,73 @@
+
+#include "pinta/lodshape.h"
+#include "pinta/meshfactory.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pinta {
+
+const int LodShape::LEVELS;
+const float LodShape::DEFAULT_TOLERANCE = 0.5;
+
+LodShape::LodShape(const ShapeDescription &shape, float tolerance):
+    shape(shape), tolerance(tolerance)
+{
+    for (std::atomic<const Mesh *> &level: levels) {
+        level = nullptr;
+    }
+}
+
+const Mesh * LodShape::getMesh(float pixelScale) const
+{
+    return getMeshOfLevel(getLevel(pixelScale));
+}
+
+const Mesh * LodShape::getMesh(const Transform2D &modelview, const glm::vec2 &scale, int viewportWidth,
+    int viewportHeight) const
+{
+    // The scale in pixels of the longer axis of the item
+    glm::vec2 axes = modelview.getScale();
+    return getMesh(std::max(axes.x * std::abs(scale.x) * viewportWidth, axes.y * std::abs(scale.y) * viewportHeight) / 2);
+}
+
+const Mesh * LodShape::getMeshOfLevel(int level) const
+{
+    const Mesh *mesh = levels[level].load(std::memory_order_acquire);
+    if (mesh) {
+        return mesh;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!meshes[level]) {
+        ShapeDescription description = shape;
+        description.segments = getSegments(level);
+        meshes[level].reset(createMesh(description));
+        levels[level].store(meshes[level].get(), std::memory_order_release);
+    }
+    return meshes[level].get();
+}
+
+int LodShape::getSegments(int level) const
+{
+    // From 4 to 256 segments in a circle, from 1 to 64 in a corner
+    return (shape.type == ShapeDescription::CIRCLE ? 4 : 1) << level;
+}
+
+int LodShape::levelFor(float pixelScale, float tolerance) const
+{
+    // A chord of a circle of radius r over an angle a is r (1 - cos(a / 2))
+    // away from the arc at most
+    float radius = std::min(shape.cornerRadius, std::min(shape.width, shape.height) / 2) * pixelScale;
+    if (radius <= tolerance) {
+        return 0;
+    }
+    float segments = 2 * M_PI / (2 * std::acos(1 - tolerance / radius));
+    int level = 0;
+    while (level < LEVELS - 1 && getSegments(level) * (shape.type == ShapeDescription::CIRCLE ? 1 : 4) < segments) {
+        level++;
+    }
+    return level;
+}
+
+}
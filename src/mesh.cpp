@@ -3,9 +3,29 @@
 
 namespace pinta {
 
+std::atomic<unsigned int> Mesh::nextGeneration(1);
+
 Mesh::Mesh(GLenum primitive):
-    primitive(primitive)
+    primitive(primitive), generation(0), indexGeneration(0)
+{
+}
+
+Mesh::Mesh(const Mesh &other):
+    primitive(other.primitive), vertices(other.vertices), indices(other.indices), bounds(other.bounds),
+    generation(other.generation), indexGeneration(other.indexGeneration)
+{
+}
+
+const Mesh & Mesh::operator=(const Mesh &other)
 {
+    primitive = other.primitive;
+    vertices = other.vertices;
+    indices = other.indices;
+    bounds = other.bounds;
+    generation = other.generation;
+    indexGeneration = other.indexGeneration;
+    notifyChange();
+    return *this;
 }
 
 void Mesh::setColor(const Color &color)
@@ -13,6 +33,46 @@ void Mesh::setColor(const Color &color)
     for (Vertex &vertex: vertices) {
         vertex.setColor(color);
     }
+    generation = nextGeneration++;
+    notifyChange();
+}
+
+void Mesh::setIndices(const std::vector<GLuint> &indices)
+{
+    this->indices = indices;
+    generation = indexGeneration = nextGeneration++;
+    notifyChange();
+}
+
+void Mesh::setPrimitive(GLenum primitive)
+{
+    this->primitive = primitive;
+    generation = indexGeneration = nextGeneration++;
+    notifyChange();
+}
+
+void Mesh::setVertices(const std::vector<Vertex> &vertices)
+{
+    this->vertices = vertices;
+    bounds = BoundingBox::fromVertices(vertices);
+    generation = nextGeneration++;
+    notifyChange();
+}
+
+void Mesh::notifyChange()
+{
+    // Changes made in a row are listed once
+    for (auto it = changeLists.begin(); it != changeLists.end();) {
+        std::shared_ptr<std::vector<const Mesh *>> changeList = it->lock();
+        if (!changeList) {
+            it = changeLists.erase(it);
+            continue;
+        }
+        if (changeList->empty() || changeList->back() != this) {
+            changeList->push_back(this);
+        }
+        ++it;
+    }
 }
 
 }
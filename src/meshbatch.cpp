@@ -0,0 +1,23 @@
+
+#include "pinta/meshbatch.h"
+
+namespace pinta {
+
+// Generation 0 is the one of empty batches, never tessellated
+std::atomic<unsigned int> MeshBatch::nextGeneration(1);
+
+MeshBatch::MeshBatch():
+    generation(0)
+{
+
+}
+
+Mesh * MeshBatch::createMesh(size_t mesh) const
+{
+    Mesh *result = new Mesh(primitives[mesh]);
+    result->setVertices(std::vector<Vertex>(vertices.begin() + firstVertices[mesh], vertices.begin() + firstVertices[mesh + 1]));
+    result->setIndices(std::vector<GLuint>(indices.begin() + firstIndices[mesh], indices.begin() + firstIndices[mesh + 1]));
+    return result;
+}
+
+}
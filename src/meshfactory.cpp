@@ -1,5 +1,9 @@
 
+#include "pinta/circlepoints.h"
 #include "pinta/meshfactory.h"
+#include "pinta/meshbatch.h"
+#include "pinta/scopedphase.h"
+#include "pinta/tessellationcache.h"
 
 #include <algorithm>
 #include <cassert>
@@ -8,85 +12,224 @@
 namespace pinta {
 
 static const float EPSILON = 1.0;
+static const Color WHITE(255, 255, 255);
+
+static TessellationCache cache;
 
 static void arc(float x, float y, float cornerRadius, float startingAngle, float angle, int segments,
-    std::vector<Vertex> &vertices, std::vector<GLushort> &indices);
+    std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
 
-static Mesh * createPlainRectangle(float w, float h, const Color &color);
-static Mesh * createRoundRectangle(float w, float h, float cornerRadius, const Color &color,
-    int segments, bool widthCollapsed, bool heightCollapsed);
+static void circleGeometry(float radius, int segments, std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+static Mesh * createGeometryMesh(const ShapeDescription &shape);
+static GLenum geometry(const ShapeDescription &shape, std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+static GLenum getGeometrySize(const ShapeDescription &shape, size_t &vertexCount, size_t &indexCount);
+static ShapeDescription normalize(const ShapeDescription &shape);
+static void plainRectangleGeometry(float w, float h, std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+static void roundRectangleGeometry(float w, float h, float cornerRadius, int segments, bool widthCollapsed,
+    bool heightCollapsed, std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
 
 Mesh * rectangle(float w, float h, float cornerRadius, const Color &color, int segments)
+{
+    Mesh *mesh = new Mesh(*sharedRectangle(w, h, cornerRadius, segments));
+    mesh->setColor(color);
+    return mesh;
+}
+
+Mesh * circle(float radius, const Color &color, int segments)
+{
+    Mesh *mesh = new Mesh(*sharedCircle(radius, segments));
+    mesh->setColor(color);
+    return mesh;
+}
+
+Mesh * createMesh(const ShapeDescription &shape)
+{
+    assert(shape.width > 0 && shape.height > 0);
+    assert(shape.cornerRadius <= 0 || shape.segments > 0);
+    Mesh *mesh = createGeometryMesh(normalize(shape));
+    mesh->setColor(shape.color);
+    return mesh;
+}
+
+std::shared_ptr<const Mesh> sharedRectangle(float w, float h, float cornerRadius, int segments)
 {
     assert(w > 0 && h > 0);
+    assert(cornerRadius <= 0 || segments > 0);
 
-    if (cornerRadius <= 0) {
-        return createPlainRectangle(w, h, color);
-    } else {
-        assert(segments > 0);
-        cornerRadius = std::min(std::min(w, h)/2.0f, cornerRadius);
-        bool widthCollapsed = std::abs(cornerRadius - w/2.0) < EPSILON;
-        bool heightCollapsed = std::abs(cornerRadius - h/2.0) < EPSILON;
-        if (widthCollapsed && heightCollapsed) {
-            return circle(cornerRadius, color, segments * 4);
-        } else {
-            return createRoundRectangle(w, h, cornerRadius, color, segments, widthCollapsed, heightCollapsed);
-        }
+    ShapeDescription shape = normalize(ShapeDescription::rectangle(w, h, cornerRadius, WHITE, segments));
+    if (shape.type == ShapeDescription::CIRCLE) {
+        return sharedCircle(shape.cornerRadius, shape.segments);
     }
+    TessellationKey key(TessellationKey::RECTANGLE, w, h, shape.cornerRadius, shape.segments);
+    std::shared_ptr<const Mesh> mesh = cache.find(key);
+    return mesh ? mesh : cache.insert(key, createGeometryMesh(shape));
 }
 
-Mesh * circle(float radius, const Color &color, int segments)
+std::shared_ptr<const Mesh> sharedCircle(float radius, int segments)
 {
-    Mesh *mesh = new Mesh(GL_TRIANGLE_FAN);
-    std::vector<Vertex> vertices;
-    std::vector<GLushort> indices;
+    assert(radius > 0 && segments > 0);
 
-    vertices.push_back(Vertex(0, 0));
-    for (int i = 0; i < segments; i++) {
-        float angle = (M_PI*2) * (static_cast<float>(i)/static_cast<float>(segments));
-        vertices.push_back(Vertex(cos(angle) * radius, sin(angle) * radius));
+    TessellationKey key(TessellationKey::CIRCLE, radius * 2, radius * 2, radius, segments);
+    std::shared_ptr<const Mesh> mesh = cache.find(key);
+    return mesh ? mesh : cache.insert(key, createGeometryMesh(ShapeDescription::circle(radius, WHITE, segments)));
+}
+
+void tessellate(const std::vector<ShapeDescription> &shapes, MeshBatch &batch)
+{
+    tessellate(shapes, batch, threadPool());
+}
+
+void tessellate(const std::vector<ShapeDescription> &shapes, MeshBatch &batch, ThreadPool &pool)
+{
+    PINTA_PHASE(TESSELLATE);
+
+    // The size of every shape is known beforehand, so each one is written to
+    // its own place in the batch, whatever thread tessellates it
+    size_t count = shapes.size();
+    batch.primitives.resize(count);
+    batch.firstVertices.resize(count + 1);
+    batch.firstIndices.resize(count + 1);
+    batch.firstVertices[0] = 0;
+    batch.firstIndices[0] = 0;
+    for (size_t i = 0; i < count; i++) {
+        assert(shapes[i].width > 0 && shapes[i].height > 0);
+        assert(shapes[i].cornerRadius <= 0 || shapes[i].segments > 0);
+        size_t vertexCount;
+        size_t indexCount;
+        batch.primitives[i] = getGeometrySize(normalize(shapes[i]), vertexCount, indexCount);
+        batch.firstVertices[i + 1] = batch.firstVertices[i] + vertexCount;
+        batch.firstIndices[i + 1] = batch.firstIndices[i] + indexCount;
     }
+    batch.vertices.resize(batch.firstVertices[count]);
+    batch.indices.resize(batch.firstIndices[count]);
+    batch.generation = MeshBatch::nextGeneration++;
+
+    pool.run(count, [&](size_t i) {
+        static thread_local std::vector<Vertex> vertices;
+        static thread_local std::vector<GLuint> indices;
+        vertices.clear();
+        indices.clear();
+        const ShapeDescription &shape = shapes[i];
+        geometry(normalize(shape), vertices, indices);
+        assert(vertices.size() == batch.getVertexCount(i) && indices.size() == batch.getIndexCount(i));
+        for (Vertex &vertex: vertices) {
+            vertex.setColor(shape.color);
+        }
+        std::copy(vertices.begin(), vertices.end(), batch.vertices.begin() + batch.firstVertices[i]);
+        std::copy(indices.begin(), indices.end(), batch.indices.begin() + batch.firstIndices[i]);
+    });
+}
+
+TessellationCache & tessellationCache()
+{
+    return cache;
+}
+
+void circleGeometry(float radius, int segments, std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+    vertices.resize(segments + 1);
+    circlePoints(0, 0, radius, 0, (M_PI*2) / segments, segments, &vertices[1]);
     indices.push_back(0);
     indices.push_back(1);
     for (int i = segments; i > 0; i--) {
         indices.push_back(i);
     }
+}
 
+Mesh * createGeometryMesh(const ShapeDescription &shape)
+{
+    PINTA_PHASE(TESSELLATE);
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    Mesh *mesh = new Mesh(geometry(shape, vertices, indices));
     mesh->setVertices(vertices);
     mesh->setIndices(indices);
-    mesh->setColor(color);
+    mesh->setColor(WHITE);
     return mesh;
 }
 
-void arc(float x, float y, float radius, float startAngle, float angle, int segments, std::vector<Vertex> &vertices, std::vector<GLushort> &indices)
+void arc(float x, float y, float radius, float startAngle, float angle, int segments, std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
 {
     int firstIndex = vertices.size();
-    vertices.push_back(Vertex(x, y));
-    vertices.push_back(Vertex(x + cos(startAngle) * radius, y + sin(startAngle) * radius));
+    vertices.resize(firstIndex + segments + 2);
+    vertices[firstIndex] = Vertex(x, y);
+    circlePoints(x, y, radius, startAngle, angle / segments, segments + 1, &vertices[firstIndex + 1]);
     for (int i = 0; i < segments; i++) {
-        float currentAngle = startAngle + angle * ((i + 1.0)/segments);
-        vertices.push_back(Vertex(x + cos(currentAngle) * radius, y + sin(currentAngle) * radius));
         indices.push_back(firstIndex);
         indices.push_back(firstIndex + i + 1);
         indices.push_back(firstIndex + i + 2);
     }
 }
 
-Mesh * createPlainRectangle(float w, float h, const Color &color)
+GLenum geometry(const ShapeDescription &shape, std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
 {
-    Mesh *mesh = new Mesh(GL_TRIANGLE_STRIP);
-    mesh->setVertices({Vertex(-w/2.0, -h/2.0), Vertex(-w/2.0, h/2.0), Vertex(w/2.0, -h/2.0), Vertex(w/2.0, h/2.0)});
-    mesh->setIndices({0, 1, 2, 3});
-    mesh->setColor(color);
-    return mesh;
+    // Fills the empty vectors with the shape and returns its primitive
+    if (shape.type == ShapeDescription::CIRCLE) {
+        circleGeometry(shape.cornerRadius, shape.segments, vertices, indices);
+        return GL_TRIANGLE_FAN;
+    } else if (shape.cornerRadius <= 0) {
+        plainRectangleGeometry(shape.width, shape.height, vertices, indices);
+        return GL_TRIANGLE_STRIP;
+    } else {
+        roundRectangleGeometry(shape.width, shape.height, shape.cornerRadius, shape.segments,
+            std::abs(shape.cornerRadius - shape.width/2.0) < EPSILON, std::abs(shape.cornerRadius - shape.height/2.0) < EPSILON,
+            vertices, indices);
+        return GL_TRIANGLES;
+    }
 }
 
-Mesh * createRoundRectangle(float w, float h, float cornerRadius, const Color &color, int segments, bool widthCollapsed, bool heightCollapsed)
+GLenum getGeometrySize(const ShapeDescription &shape, size_t &vertexCount, size_t &indexCount)
 {
-    Mesh *mesh = new Mesh(GL_TRIANGLES);
-    std::vector<Vertex> vertices;
-    std::vector<GLushort> indices;
+    // The counts of the vertices and indices added by geometry
+    int segments = shape.segments;
+    if (shape.type == ShapeDescription::CIRCLE) {
+        vertexCount = segments + 1;
+        indexCount = segments + 2;
+        return GL_TRIANGLE_FAN;
+    } else if (shape.cornerRadius <= 0) {
+        vertexCount = 4;
+        indexCount = 4;
+        return GL_TRIANGLE_STRIP;
+    } else if (std::abs(shape.cornerRadius - shape.width/2.0) < EPSILON
+            || std::abs(shape.cornerRadius - shape.height/2.0) < EPSILON) {
+        vertexCount = 4 * segments + 4;
+        indexCount = 12 * segments + 12;
+        return GL_TRIANGLES;
+    } else {
+        vertexCount = 4 * segments + 8;
+        indexCount = 12 * segments + 30;
+        return GL_TRIANGLES;
+    }
+}
+
+ShapeDescription normalize(const ShapeDescription &shape)
+{
+    // Round rectangles whose corners fill both sides are circles
+    ShapeDescription normalized = shape;
+    if (shape.type == ShapeDescription::RECTANGLE) {
+        if (shape.cornerRadius <= 0) {
+            normalized.cornerRadius = 0;
+            normalized.segments = 0;
+        } else {
+            normalized.cornerRadius = std::min(std::min(shape.width, shape.height)/2.0f, shape.cornerRadius);
+            if (std::abs(normalized.cornerRadius - shape.width/2.0) < EPSILON
+                    && std::abs(normalized.cornerRadius - shape.height/2.0) < EPSILON) {
+                normalized = ShapeDescription::circle(normalized.cornerRadius, shape.color, shape.segments * 4);
+            }
+        }
+    }
+    return normalized;
+}
 
+void plainRectangleGeometry(float w, float h, std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+    vertices.insert(vertices.end(), {Vertex(-w/2.0, -h/2.0), Vertex(-w/2.0, h/2.0), Vertex(w/2.0, -h/2.0), Vertex(w/2.0, h/2.0)});
+    indices.insert(indices.end(), {0, 1, 2, 3});
+}
+
+void roundRectangleGeometry(float w, float h, float cornerRadius, int segments, bool widthCollapsed, bool heightCollapsed,
+    std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
     if (widthCollapsed || heightCollapsed) {
         float angle0;
         float angle1;
@@ -151,10 +294,6 @@ Mesh * createRoundRectangle(float w, float h, float cornerRadius, const Color &c
         indices.push_back(vertex2);
         indices.push_back(0);
     }
-    mesh->setVertices(vertices);
-    mesh->setIndices(indices);
-    mesh->setColor(color);
-    return mesh;
 }
 
 }
\ No newline at end of file
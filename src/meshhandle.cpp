@@ -0,0 +1,11 @@
+
+#include "pinta/meshhandle.h"
+
+namespace pinta {
+
+MeshHandle::MeshHandle(uint32_t index, uint32_t generation):
+    index(index), generation(generation)
+{
+}
+
+}
@@ -0,0 +1,169 @@
+
+#include "pinta/meshstore.h"
+
+#include <algorithm>
+
+namespace pinta {
+
+std::atomic<unsigned int> MeshStore::nextGeneration(1);
+
+MeshStore::MeshStore():
+    unusedVertices(0), unusedIndices(0)
+{
+}
+
+MeshHandle MeshStore::add(const Mesh &mesh)
+{
+    return add(mesh.getPrimitive(), mesh.getVertices(), mesh.getIndices());
+}
+
+MeshHandle MeshStore::add(GLenum primitive, const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices)
+{
+    uint32_t index;
+    if (freeSlots.empty()) {
+        // Generations start at 1 so that default handles are never valid
+        index = slots.size();
+        slots.push_back(Slot());
+        handles.push_back(1);
+    } else {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+        handles[index]++;
+    }
+
+    Slot &slot = slots[index];
+    slot.primitive = primitive;
+    slot.bounds = BoundingBox::fromVertices(vertices);
+    slot.firstVertex = this->vertices.size();
+    slot.vertexCount = vertices.size();
+    slot.firstIndex = this->indices.size();
+    slot.indexCount = indices.size();
+    slot.generation = slot.indexGeneration = nextGeneration++;
+    this->vertices.insert(this->vertices.end(), vertices.begin(), vertices.end());
+    this->indices.insert(this->indices.end(), indices.begin(), indices.end());
+    return MeshHandle(index, handles[index]);
+}
+
+void MeshStore::clear()
+{
+    for (uint32_t index = 0; index < slots.size(); index++) {
+        destroy(MeshHandle(index, handles[index]));
+    }
+    vertices.clear();
+    indices.clear();
+    unusedVertices = 0;
+    unusedIndices = 0;
+}
+
+Mesh * MeshStore::createMesh(MeshHandle handle) const
+{
+    if (!isValid(handle)) {
+        return nullptr;
+    }
+    const Slot &slot = slots[handle.index];
+    Mesh *mesh = new Mesh(slot.primitive);
+    mesh->setVertices(std::vector<Vertex>(vertices.begin() + slot.firstVertex, vertices.begin() + slot.firstVertex + slot.vertexCount));
+    mesh->setIndices(std::vector<GLuint>(indices.begin() + slot.firstIndex, indices.begin() + slot.firstIndex + slot.indexCount));
+    return mesh;
+}
+
+void MeshStore::destroy(MeshHandle handle)
+{
+    if (!isValid(handle)) {
+        return;
+    }
+    Slot &slot = slots[handle.index];
+    unusedVertices += slot.vertexCount;
+    unusedIndices += slot.indexCount;
+    slot.vertexCount = 0;
+    slot.indexCount = 0;
+    handles[handle.index]++;
+    freeSlots.push_back(handle.index);
+    compact();
+}
+
+void MeshStore::setColor(MeshHandle handle, const Color &color)
+{
+    if (!isValid(handle)) {
+        return;
+    }
+    Slot &slot = slots[handle.index];
+    for (size_t i = slot.firstVertex; i < slot.firstVertex + slot.vertexCount; i++) {
+        vertices[i].setColor(color);
+    }
+    slot.generation = nextGeneration++;
+}
+
+void MeshStore::setIndices(MeshHandle handle, const std::vector<GLuint> &indices)
+{
+    if (!isValid(handle)) {
+        return;
+    }
+    Slot &slot = slots[handle.index];
+    if (indices.size() != slot.indexCount) {
+        unusedIndices += slot.indexCount;
+        slot.firstIndex = this->indices.size();
+        slot.indexCount = indices.size();
+        this->indices.insert(this->indices.end(), indices.begin(), indices.end());
+        compact();
+    } else {
+        std::copy(indices.begin(), indices.end(), this->indices.begin() + slot.firstIndex);
+    }
+    slot.generation = slot.indexGeneration = nextGeneration++;
+}
+
+void MeshStore::setPrimitive(MeshHandle handle, GLenum primitive)
+{
+    if (!isValid(handle)) {
+        return;
+    }
+    Slot &slot = slots[handle.index];
+    slot.primitive = primitive;
+    slot.generation = slot.indexGeneration = nextGeneration++;
+}
+
+void MeshStore::setVertices(MeshHandle handle, const std::vector<Vertex> &vertices)
+{
+    if (!isValid(handle)) {
+        return;
+    }
+    Slot &slot = slots[handle.index];
+    if (vertices.size() != slot.vertexCount) {
+        unusedVertices += slot.vertexCount;
+        slot.firstVertex = this->vertices.size();
+        slot.vertexCount = vertices.size();
+        this->vertices.insert(this->vertices.end(), vertices.begin(), vertices.end());
+        compact();
+    } else {
+        std::copy(vertices.begin(), vertices.end(), this->vertices.begin() + slot.firstVertex);
+    }
+    slot.bounds = BoundingBox::fromVertices(vertices);
+    slot.generation = nextGeneration++;
+}
+
+void MeshStore::compact()
+{
+    if (unusedVertices <= vertices.size() / 2 && unusedIndices <= indices.size() / 2) {
+        return;
+    }
+
+    // The meshes in use are copied in the order of their slots
+    std::vector<Vertex> compactVertices;
+    std::vector<GLuint> compactIndices;
+    compactVertices.reserve(vertices.size() - unusedVertices);
+    compactIndices.reserve(indices.size() - unusedIndices);
+    for (Slot &slot: slots) {
+        compactVertices.insert(compactVertices.end(), vertices.begin() + slot.firstVertex,
+            vertices.begin() + slot.firstVertex + slot.vertexCount);
+        compactIndices.insert(compactIndices.end(), indices.begin() + slot.firstIndex,
+            indices.begin() + slot.firstIndex + slot.indexCount);
+        slot.firstVertex = compactVertices.size() - slot.vertexCount;
+        slot.firstIndex = compactIndices.size() - slot.indexCount;
+    }
+    vertices.swap(compactVertices);
+    indices.swap(compactIndices);
+    unusedVertices = 0;
+    unusedIndices = 0;
+}
+
+}
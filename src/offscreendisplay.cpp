@@ -0,0 +1,163 @@
+
+#include "pinta/offscreendisplay.h"
+#include "pinta/displayerror.h"
+#include "pinta/extensions.h"
+#include "pinta/scopedphase.h"
+
+#include <EGL/eglext.h>
+#include <algorithm>
+#include <sstream>
+
+namespace pinta {
+
+static DisplayError eglError(const char *call);
+
+OffscreenDisplay::OffscreenDisplay(int width, int height):
+    width(width), height(height), display(EGL_NO_DISPLAY), surface(EGL_NO_SURFACE), context(EGL_NO_CONTEXT), framebuffer(0),
+    colorTexture(0), stencilBuffer(0), frame(0)
+{
+    // The destructor doesn't run when the constructor throws, so whatever
+    // was created until then is released here
+    try {
+        init();
+        initFramebuffer();
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+OffscreenDisplay::~OffscreenDisplay()
+{
+    release();
+}
+
+void OffscreenDisplay::makeCurrent(bool current)
+{
+    bool made = current ? eglMakeCurrent(display, surface, surface, context)
+        : eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (!made) {
+        throw eglError("eglMakeCurrent");
+    }
+}
+
+void OffscreenDisplay::readPixels(std::vector<uint8_t> &pixels) const
+{
+    // RGBA rows from the top of the image down
+    pixels.resize(width * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    for (int row = 0; row < height / 2; row++) {
+        std::swap_ranges(pixels.begin() + row * width * 4, pixels.begin() + (row + 1) * width * 4,
+            pixels.begin() + (height - 1 - row) * width * 4);
+    }
+}
+
+void OffscreenDisplay::swap()
+{
+    PINTA_PHASE(SWAP);
+    // Without a surface to present, the end of a frame is when the GPU is done
+    glFinish();
+    frame++;
+}
+
+void OffscreenDisplay::init()
+{
+    bool surfaceless = false;
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (hasExtension(clientExtensions, "EGL_EXT_platform_base")
+            && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        surfaceless = display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr);
+    }
+    if (!surfaceless) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+            throw eglError("eglInitialize");
+        }
+    }
+    if (!eglBindAPI(EGL_OPENGL_ES_API)) {
+        throw eglError("eglBindAPI");
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        throw eglError("eglChooseConfig");
+    }
+
+    const EGLint contextAttributes[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        throw eglError("eglCreateContext");
+    }
+
+    // The pbuffer is only there to make the context current, everything is
+    // drawn to the framebuffer object
+    if (!surfaceless) {
+        const EGLint surfaceAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        if (surface == EGL_NO_SURFACE) {
+            throw eglError("eglCreatePbufferSurface");
+        }
+    }
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        throw eglError("eglMakeCurrent");
+    }
+}
+
+void OffscreenDisplay::initFramebuffer()
+{
+    glGenTextures(1, &colorTexture);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glGenRenderbuffers(1, &stencilBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, stencilBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, width, height);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, stencilBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        throw DisplayError("incomplete offscreen framebuffer");
+    }
+}
+
+void OffscreenDisplay::release()
+{
+    // The GL objects only exist once the context has been made current
+    if (framebuffer || colorTexture || stencilBuffer) {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &colorTexture);
+        glDeleteRenderbuffers(1, &stencilBuffer);
+    }
+    if (context != EGL_NO_CONTEXT) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+    }
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface);
+    }
+    if (display != EGL_NO_DISPLAY) {
+        eglTerminate(display);
+    }
+}
+
+DisplayError eglError(const char *call)
+{
+    std::ostringstream message;
+    message << "error on " << call << ": 0x" << std::hex << eglGetError();
+    return DisplayError(message.str());
+}
+
+}
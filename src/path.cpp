@@ -0,0 +1,102 @@
+
+#include "pinta/path.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pinta {
+
+Path::Path():
+    contourStart(0), hasCurrentPoint(false)
+{
+}
+
+void Path::arc(const glm::vec2 &center, float radius, float startAngle, float endAngle)
+{
+    glm::vec2 start = center + glm::vec2(std::cos(startAngle), std::sin(startAngle)) * radius;
+    if (hasCurrentPoint) {
+        lineTo(start);
+    } else {
+        moveTo(start);
+    }
+
+    // A cubic curve per quarter of a circle at most, with the control points
+    // on the tangents at a distance that matches the arc at its middle
+    float sweep = endAngle - startAngle;
+    int pieces = std::max(1, int(std::ceil(std::abs(sweep) / (M_PI / 2) - 1e-4)));
+    float step = sweep / pieces;
+    float handle = 4.0 / 3.0 * std::tan(step / 4) * radius;
+    float angle = startAngle;
+    for (int i = 0; i < pieces; i++) {
+        glm::vec2 from(std::cos(angle), std::sin(angle));
+        glm::vec2 to(std::cos(angle + step), std::sin(angle + step));
+        cubicTo(center + from * radius + glm::vec2(-from.y, from.x) * handle,
+            center + to * radius - glm::vec2(-to.y, to.x) * handle, center + to * radius);
+        angle += step;
+    }
+}
+
+void Path::clear()
+{
+    verbs.clear();
+    points.clear();
+    contourStart = 0;
+    hasCurrentPoint = false;
+}
+
+void Path::close()
+{
+    if (hasCurrentPoint && verbs.back() != CLOSE) {
+        verbs.push_back(CLOSE);
+    }
+}
+
+void Path::cubicTo(const glm::vec2 &control1, const glm::vec2 &control2, const glm::vec2 &point)
+{
+    ensureContour(control1);
+    verbs.push_back(CUBIC);
+    points.push_back(control1);
+    points.push_back(control2);
+    points.push_back(point);
+}
+
+void Path::lineTo(const glm::vec2 &point)
+{
+    ensureContour(point);
+    verbs.push_back(LINE);
+    points.push_back(point);
+}
+
+void Path::moveTo(const glm::vec2 &point)
+{
+    contourStart = points.size();
+    verbs.push_back(MOVE);
+    points.push_back(point);
+    hasCurrentPoint = true;
+}
+
+void Path::quadTo(const glm::vec2 &control, const glm::vec2 &point)
+{
+    ensureContour(control);
+    verbs.push_back(QUAD);
+    points.push_back(control);
+    points.push_back(point);
+}
+
+void Path::reserve(size_t verbs, size_t points)
+{
+    this->verbs.reserve(verbs);
+    this->points.reserve(points);
+}
+
+void Path::ensureContour(const glm::vec2 &point)
+{
+    if (!hasCurrentPoint) {
+        moveTo(point);
+    } else if (verbs.back() == CLOSE) {
+        // A closed contour is followed by one from the same start
+        moveTo(glm::vec2(points[contourStart]));
+    }
+}
+
+}
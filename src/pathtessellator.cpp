@@ -0,0 +1,380 @@
+
+#include "pinta/pathtessellator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace pinta {
+
+const float PathTessellator::DEFAULT_TOLERANCE = 0.25;
+const int PathTessellator::MAX_CURVE_SEGMENTS = 1024;
+
+static inline float cross(const glm::vec2 &a, const glm::vec2 &b);
+
+PathTessellator::PathTessellator(float tolerance):
+    tolerance(tolerance), cellSize(1.0), gridSize(0), orientation(1.0), polygon(nullptr)
+{
+}
+
+void PathTessellator::fill(const Path &path, const Color &color, std::vector<Vertex> &vertices,
+    std::vector<GLuint> &indices)
+{
+    flatten(path, true);
+    for (const Contour &contour: contours) {
+        if (contour.count < 3) {
+            continue;
+        }
+        GLuint base = vertices.size();
+        for (size_t i = contour.first; i < contour.first + contour.count; i++) {
+            vertices.push_back(Vertex(points[i].x, points[i].y, color));
+        }
+        clipEars(contour, base, indices);
+    }
+}
+
+void PathTessellator::stroke(const Path &path, const StrokeStyle &style, const Color &color,
+    std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+    flatten(path, false);
+    float halfWidth = style.width / 2;
+    for (const Contour &contour: contours) {
+        if (contour.count < 2) {
+            continue;
+        }
+
+        // A quad for each segment: its left and its right side at the start,
+        // then the same at the end
+        const glm::vec2 *contourPoints = &points[contour.first];
+        int count = contour.count;
+        int segments = contour.closed ? count : count - 1;
+        bool squareCaps = !contour.closed && style.cap == StrokeStyle::SQUARE_CAP;
+        GLuint base = vertices.size();
+        for (int i = 0; i < segments; i++) {
+            glm::vec2 from = contourPoints[i];
+            glm::vec2 to = contourPoints[(i + 1) % count];
+            glm::vec2 direction = glm::normalize(to - from);
+            glm::vec2 normal = glm::vec2(-direction.y, direction.x) * halfWidth;
+            if (squareCaps && i == 0) {
+                from = from - direction * halfWidth;
+            }
+            if (squareCaps && i == segments - 1) {
+                to = to + direction * halfWidth;
+            }
+            vertices.push_back(Vertex(from.x + normal.x, from.y + normal.y, color));
+            vertices.push_back(Vertex(from.x - normal.x, from.y - normal.y, color));
+            vertices.push_back(Vertex(to.x + normal.x, to.y + normal.y, color));
+            vertices.push_back(Vertex(to.x - normal.x, to.y - normal.y, color));
+            GLuint quad = base + 4 * i;
+            indices.insert(indices.end(), {quad, quad + 1, quad + 2, quad + 2, quad + 1, quad + 3});
+        }
+
+        for (int i = contour.closed ? 0 : 1; i < (contour.closed ? count : count - 1); i++) {
+            int before = (i + segments - 1) % segments;
+            addJoin(contourPoints[i], glm::normalize(contourPoints[i] - contourPoints[(i + count - 1) % count]),
+                glm::normalize(contourPoints[(i + 1) % count] - contourPoints[i]), base + 4 * before + 2, base + 4 * i,
+                style, color, vertices, indices);
+        }
+
+        if (!contour.closed && style.cap == StrokeStyle::ROUND_CAP) {
+            // Half circles from the left side to the right one around the ends
+            glm::vec2 start = contourPoints[0];
+            glm::vec2 startDirection = glm::normalize(contourPoints[1] - start);
+            GLuint center = vertices.size();
+            vertices.push_back(Vertex(start.x, start.y, color));
+            addArc(start, center, glm::vec2(-startDirection.y, startDirection.x) * halfWidth, M_PI, base, base + 1,
+                color, vertices, indices);
+            glm::vec2 end = contourPoints[count - 1];
+            glm::vec2 endDirection = glm::normalize(end - contourPoints[count - 2]);
+            GLuint lastQuad = base + 4 * (segments - 1);
+            center = vertices.size();
+            vertices.push_back(Vertex(end.x, end.y, color));
+            addArc(end, center, glm::vec2(endDirection.y, -endDirection.x) * halfWidth, M_PI, lastQuad + 3,
+                lastQuad + 2, color, vertices, indices);
+        }
+    }
+}
+
+void PathTessellator::addArc(const glm::vec2 &center, GLuint centerVertex, const glm::vec2 &from, float angle,
+    GLuint first, GLuint last, const Color &color, std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+    // Chords no further than the tolerance from the arc, as in LodShape
+    float radius = glm::length(from);
+    float maxStep = radius > tolerance ? 2 * std::acos(1 - tolerance / radius) : M_PI;
+    int steps = std::max(1, int(std::ceil(std::abs(angle) / maxStep)));
+    float cosStep = std::cos(angle / steps);
+    float sinStep = std::sin(angle / steps);
+    glm::vec2 offset = from;
+    GLuint previousVertex = first;
+    for (int i = 1; i < steps; i++) {
+        offset = glm::vec2(offset.x * cosStep - offset.y * sinStep, offset.x * sinStep + offset.y * cosStep);
+        GLuint vertex = vertices.size();
+        vertices.push_back(Vertex(center.x + offset.x, center.y + offset.y, color));
+        indices.insert(indices.end(), {centerVertex, previousVertex, vertex});
+        previousVertex = vertex;
+    }
+    indices.insert(indices.end(), {centerVertex, previousVertex, last});
+}
+
+void PathTessellator::addJoin(const glm::vec2 &point, const glm::vec2 &before, const glm::vec2 &after,
+    GLuint beforeVertices, GLuint afterVertices, const StrokeStyle &style, const Color &color,
+    std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+    float turn = cross(before, after);
+    float dot = glm::dot(before, after);
+    if (std::abs(turn) < 1e-6 && dot > 0) {
+        return;
+    }
+
+    // The gap between the segments is on the right side of a left turn
+    float side = turn > 0 ? -1.0 : 1.0;
+    GLuint outerBefore = beforeVertices + (turn > 0 ? 1 : 0);
+    GLuint outerAfter = afterVertices + (turn > 0 ? 1 : 0);
+    GLuint center = vertices.size();
+    vertices.push_back(Vertex(point.x, point.y, color));
+    float halfWidth = style.width / 2;
+    glm::vec2 beforeNormal(-before.y, before.x);
+    if (style.join == StrokeStyle::ROUND_JOIN) {
+        addArc(point, center, beforeNormal * (side * halfWidth), std::atan2(turn, dot), outerBefore, outerAfter, color,
+            vertices, indices);
+        return;
+    }
+    if (style.join == StrokeStyle::MITER_JOIN) {
+        // The miter is 1 / cos(turn / 2) times as long as the half width
+        glm::vec2 miter = beforeNormal + glm::vec2(-after.y, after.x);
+        float cosHalfTurn = glm::length(miter) / 2;
+        if (cosHalfTurn * style.miterLimit >= 1) {
+            glm::vec2 tip = point + miter * (side * halfWidth / (2 * cosHalfTurn * cosHalfTurn));
+            GLuint tipVertex = vertices.size();
+            vertices.push_back(Vertex(tip.x, tip.y, color));
+            indices.insert(indices.end(), {center, outerBefore, tipVertex, center, tipVertex, outerAfter});
+            return;
+        }
+    }
+    indices.insert(indices.end(), {center, outerBefore, outerAfter});
+}
+
+void PathTessellator::addPoint(const glm::vec2 &point)
+{
+    if (points.size() == contours.back().first || points.back() != point) {
+        points.push_back(point);
+    }
+}
+
+void PathTessellator::clipEars(const Contour &contour, GLuint base, std::vector<GLuint> &indices)
+{
+    int count = contour.count;
+    polygon = &points[contour.first];
+    previous.resize(count);
+    next.resize(count);
+    reflex.resize(count);
+    float area = 0;
+    for (int i = 0; i < count; i++) {
+        previous[i] = (i + count - 1) % count;
+        next[i] = (i + 1) % count;
+        area += cross(polygon[i] - polygon[0], polygon[next[i]] - polygon[0]);
+    }
+    orientation = area < 0 ? -1.0 : 1.0;
+
+    // Only a reflex point can be inside an ear, and a point that is not
+    // reflex never becomes one, so the grid is built once. Flat points count
+    // as reflex ones.
+    int reflexCount = 0;
+    glm::vec2 min = polygon[0];
+    glm::vec2 max = polygon[0];
+    for (int i = 0; i < count; i++) {
+        reflex[i] = getTurn(i) <= 0;
+        if (reflex[i]) {
+            reflexCount++;
+            min = glm::min(min, polygon[i]);
+            max = glm::max(max, polygon[i]);
+        }
+    }
+    gridSize = reflexCount ? std::max(1, int(std::sqrt(float(reflexCount)))) : 0;
+    gridOrigin = min;
+    cellSize = gridSize ? std::max(std::max(max.x - min.x, max.y - min.y) / gridSize, 1e-6f) : 1.0f;
+    cellStarts.assign(gridSize * gridSize + 1, 0);
+    cellPoints.resize(reflexCount);
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < count; i++) {
+            if (reflex[i]) {
+                int x = std::min(int((polygon[i].x - gridOrigin.x) / cellSize), gridSize - 1);
+                int y = std::min(int((polygon[i].y - gridOrigin.y) / cellSize), gridSize - 1);
+                if (pass == 0) {
+                    cellStarts[y * gridSize + x + 1]++;
+                } else {
+                    cellPoints[cellStarts[y * gridSize + x]++] = i;
+                }
+            }
+        }
+        // The counts become the starts of the cells, which filling the cells
+        // moves to their ends, that is to the starts of the next ones
+        if (pass == 0) {
+            std::partial_sum(cellStarts.begin(), cellStarts.end(), cellStarts.begin());
+        } else {
+            std::copy_backward(cellStarts.begin(), cellStarts.end() - 1, cellStarts.end());
+            cellStarts[0] = 0;
+        }
+    }
+
+    int remaining = count;
+    int ear = 0;
+    int stop = 0;
+    while (remaining > 3) {
+        float turn = getTurn(ear);
+        if (turn != 0 && !isEar(ear)) {
+            ear = next[ear];
+            if (ear != stop) {
+                continue;
+            }
+            // A whole round without an ear, as the contour crosses itself:
+            // clip anyway so that it ends
+            turn = getTurn(ear);
+        }
+        int before = previous[ear];
+        int after = next[ear];
+        if (turn != 0) {
+            indices.insert(indices.end(), {base + before, base + ear, base + after});
+        }
+        next[before] = after;
+        previous[after] = before;
+        reflex[ear] = false;
+        reflex[before] = reflex[before] && getTurn(before) <= 0;
+        reflex[after] = reflex[after] && getTurn(after) <= 0;
+        remaining--;
+        ear = stop = after;
+    }
+    if (getTurn(ear) != 0) {
+        indices.insert(indices.end(), {base + previous[ear], base + ear, base + next[ear]});
+    }
+}
+
+void PathTessellator::finishContour(bool close)
+{
+    Contour &contour = contours.back();
+    if (close) {
+        while (points.size() > contour.first + 1 && points.back() == points[contour.first]) {
+            points.pop_back();
+        }
+    }
+    contour.count = points.size() - contour.first;
+    contour.closed = close;
+    if (contour.count < 2) {
+        points.resize(contour.first);
+        contours.pop_back();
+    }
+}
+
+void PathTessellator::flatten(const Path &path, bool closeAll)
+{
+    points.clear();
+    contours.clear();
+    const std::vector<glm::vec2> &pathPoints = path.getPoints();
+    size_t point = 0;
+    glm::vec2 current;
+    for (Path::Verb verb: path.getVerbs()) {
+        switch (verb) {
+        case Path::MOVE:
+            if (!contours.empty() && contours.back().count == 0) {
+                finishContour(closeAll);
+            }
+            contours.push_back({points.size(), 0, false});
+            current = pathPoints[point++];
+            addPoint(current);
+            break;
+        case Path::LINE:
+            current = pathPoints[point++];
+            addPoint(current);
+            break;
+        case Path::QUAD: {
+            // A chord is at most 1/8 of the square of the step times the
+            // second derivative away from the curve
+            glm::vec2 control = pathPoints[point];
+            glm::vec2 end = pathPoints[point + 1];
+            int segments = getCurveSegments(std::sqrt(glm::length(current - control * 2.0f + end) / (4 * tolerance)));
+            for (int i = 1; i <= segments; i++) {
+                float t = float(i) / segments;
+                float u = 1 - t;
+                addPoint(current * (u * u) + control * (2 * u * t) + end * (t * t));
+            }
+            current = end;
+            point += 2;
+            break;
+        }
+        case Path::CUBIC: {
+            glm::vec2 control1 = pathPoints[point];
+            glm::vec2 control2 = pathPoints[point + 1];
+            glm::vec2 end = pathPoints[point + 2];
+            float deviation = std::max(glm::length(current - control1 * 2.0f + control2),
+                glm::length(control1 - control2 * 2.0f + end));
+            int segments = getCurveSegments(std::sqrt(3 * deviation / (4 * tolerance)));
+            for (int i = 1; i <= segments; i++) {
+                float t = float(i) / segments;
+                float u = 1 - t;
+                addPoint(current * (u * u * u) + control1 * (3 * u * u * t) + control2 * (3 * u * t * t)
+                    + end * (t * t * t));
+            }
+            current = end;
+            point += 3;
+            break;
+        }
+        case Path::CLOSE:
+            finishContour(true);
+            break;
+        }
+    }
+    if (!contours.empty() && contours.back().count == 0) {
+        finishContour(closeAll);
+    }
+}
+
+int PathTessellator::getCurveSegments(float segments)
+{
+    return std::min(MAX_CURVE_SEGMENTS, std::max(1, int(std::ceil(segments))));
+}
+
+float PathTessellator::getTurn(int point) const
+{
+    const glm::vec2 &corner = polygon[point];
+    return orientation * cross(corner - polygon[previous[point]], polygon[next[point]] - corner);
+}
+
+bool PathTessellator::isEar(int ear) const
+{
+    if (getTurn(ear) <= 0) {
+        return false;
+    }
+
+    const glm::vec2 &a = polygon[previous[ear]];
+    const glm::vec2 &b = polygon[ear];
+    const glm::vec2 &c = polygon[next[ear]];
+    glm::vec2 min = glm::min(glm::min(a, b), c);
+    glm::vec2 max = glm::max(glm::max(a, b), c);
+    int minX = std::max(int(std::floor((min.x - gridOrigin.x) / cellSize)), 0);
+    int minY = std::max(int(std::floor((min.y - gridOrigin.y) / cellSize)), 0);
+    int maxX = std::min(int((max.x - gridOrigin.x) / cellSize), gridSize - 1);
+    int maxY = std::min(int((max.y - gridOrigin.y) / cellSize), gridSize - 1);
+    for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+            for (int i = cellStarts[y * gridSize + x]; i < cellStarts[y * gridSize + x + 1]; i++) {
+                int point = cellPoints[i];
+                const glm::vec2 &p = polygon[point];
+                if (!reflex[point] || point == previous[ear] || point == ear || point == next[ear]) {
+                    continue;
+                }
+                if (orientation * cross(b - a, p - a) >= 0 && orientation * cross(c - b, p - b) >= 0
+                        && orientation * cross(a - c, p - c) >= 0) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static inline float cross(const glm::vec2 &a, const glm::vec2 &b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+}
@@ -0,0 +1,87 @@
+#ifndef PINTA_ANIMATIONENGINE_H
+#define PINTA_ANIMATIONENGINE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "pinta/color.h"
+#include "pinta/indextable.h"
+
+namespace pinta {
+
+// Animates many values at once. The tracks are kept as arrays of each of
+// their fields, so that update evaluates all of them in a few tight loops,
+// and a finished track is replaced by the last one. Each update writes the current
+// values straight into their targets, for instance the position of an item
+// of a DrawList (see DrawList::getItem); targets must stay valid while they
+// are animated. Animating a target again replaces its animation. Pass the
+// delta returned by Clock::tick to update.
+class AnimationEngine {
+
+public:
+
+    enum Easing {
+        LINEAR,
+        EASE_IN,
+        EASE_OUT,
+        EASE_IN_OUT,
+        EASINGS
+    };
+
+    AnimationEngine();
+
+    void animate(float *target, float startValue, float endValue, float duration, Easing easing = LINEAR,
+        float delay = 0);
+    void animate(Color *target, const Color &startColor, const Color &endColor, float duration,
+        Easing easing = LINEAR, float delay = 0);
+    void cancel(const float *target);
+    void cancel(const Color *target);
+    void clear();
+    // The coefficients of the cubic, quadratic and linear terms of an easing
+    static inline const float * getEasingCoefficients(Easing easing) {return EASING_COEFFICIENTS[easing];}
+    inline size_t getSize() const {return values.targets.size() + colors.targets.size();}
+    // Makes room for the given number of tracks of values and of colors
+    void reserve(size_t valueTracks, size_t colorTracks);
+    void update(float delta);
+
+private:
+
+    // Easings are cubic polynomials, so that they are evaluated without branches
+    static const float EASING_COEFFICIENTS[EASINGS][3];
+
+    template <typename T>
+    struct Tracks {
+        std::vector<float> elapsed;
+        std::vector<float> inverseDurations;
+        std::vector<float> cubic;
+        std::vector<float> quadratic;
+        std::vector<float> linear;
+        std::vector<T> startValues;
+        std::vector<T> endValues;
+        std::vector<T *> targets;
+        // The track of each target
+        IndexTable indices;
+    };
+
+    template <typename T>
+    void add(Tracks<T> &tracks, T *target, const T &startValue, const T &endValue, float duration, Easing easing,
+        float delay);
+    template <typename T>
+    void remove(Tracks<T> &tracks, const T *target);
+    template <typename T>
+    void remove(Tracks<T> &tracks, size_t index);
+    template <typename T>
+    void reserve(Tracks<T> &tracks, size_t count);
+    template <typename T>
+    void update(Tracks<T> &tracks, float delta);
+
+    Tracks<float> values;
+    Tracks<Color> colors;
+    std::vector<float> progress;
+    std::vector<float> easedProgress;
+
+};
+
+}
+
+#endif
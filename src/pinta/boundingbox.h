@@ -0,0 +1,43 @@
+#ifndef PINTA_BOUNDINGBOX_H
+#define PINTA_BOUNDINGBOX_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "pinta/vertex.h"
+
+namespace pinta {
+
+// An axis aligned rectangle. A box that has not been given any point is empty
+// and neither contains nor intersects anything.
+class BoundingBox {
+
+public:
+
+    BoundingBox();
+    BoundingBox(const glm::vec2 &min, const glm::vec2 &max);
+
+    static BoundingBox fromVertices(const std::vector<Vertex> &vertices);
+
+    bool contains(const glm::vec2 &point) const;
+    inline const glm::vec2 & getMax() const {return max;}
+    inline const glm::vec2 & getMin() const {return min;}
+    bool intersects(const BoundingBox &other) const;
+    inline bool isEmpty() const {return min.x > max.x;}
+    void merge(const BoundingBox &other);
+    void merge(const glm::vec2 &point);
+    BoundingBox transform(const glm::vec2 &position, const glm::vec2 &scale) const;
+
+    inline bool operator==(const BoundingBox &other) const {return min == other.min && max == other.max;}
+    inline bool operator!=(const BoundingBox &other) const {return !(*this == other);}
+
+private:
+
+    glm::vec2 min;
+    glm::vec2 max;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef PINTA_BUFFERARENA_H
+#define PINTA_BUFFERARENA_H
+
+#include <GLES2/gl2.h>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "pinta/glstate.h"
+
+namespace pinta {
+
+// A GL buffer object split in slices of elements. A copy of the buffer
+// contents is kept in client memory so that the buffer can grow and its
+// slices can be moved without reading back from the GPU. If a page size is
+// given, no slice crosses a page boundary.
+class BufferArena {
+
+public:
+
+    BufferArena(GLState &state, GLenum target, GLsizei elementSize, GLsizei initialCapacity = 1024, GLsizei pageSize = 0);
+    BufferArena(const BufferArena &other) = delete;
+    ~BufferArena();
+
+    const BufferArena & operator=(const BufferArena &other) = delete;
+
+    GLsizei allocate(GLsizei count);
+    void bind() const;
+    void free(GLsizei offset, GLsizei count);
+    inline GLuint getBuffer() const {return buffer;}
+    inline GLsizei getCapacity() const {return capacity;}
+    inline const uint8_t * getData(GLsizei offset) const {return data.data() + offset * elementSize;}
+    inline GLsizei getElementSize() const {return elementSize;}
+    inline GLsizei getPageSize() const {return pageSize;}
+    // Whether a slice was freed below the end of the buffer since the last
+    // resetCompactable, so that moving slices down may close a hole
+    inline bool isCompactable() const {return compactable;}
+    bool isFragmented() const;
+    GLsizei relocate(GLsizei offset, GLsizei count);
+    inline void resetCompactable() {compactable = false;}
+    void update(GLsizei offset, GLsizei count, const void *elements);
+    void upload(GLsizei offset, GLsizei count, const void *elements);
+
+private:
+
+    GLsizei findSlice(GLsizei count, GLsizei limit) const;
+    void grow(GLsizei count);
+    void take(GLsizei offset, GLsizei count);
+
+    GLState &state;
+    GLenum target;
+    GLsizei elementSize;
+    GLsizei pageSize;
+    GLsizei capacity;
+    GLuint buffer;
+    std::vector<uint8_t> data;
+    std::map<GLsizei, GLsizei> freeSlices;
+    bool compactable;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef PINTA_CIRCLEPOINTS_H
+#define PINTA_CIRCLEPOINTS_H
+
+#include "pinta/vertex.h"
+
+namespace pinta {
+
+// Sets the positions of count vertices to the points of the circle with the
+// given center and radius, starting at startAngle and separated by step
+// radians. The colors of the vertices are not modified. Several points are
+// computed at once with the widest vector instructions of the CPU, chosen
+// on the first call.
+void circlePoints(float x, float y, float radius, float startAngle, float step, int count, Vertex *vertices);
+// The same one point at a time with the standard library, as a reference
+void circlePointsScalar(float x, float y, float radius, float startAngle, float step, int count, Vertex *vertices);
+
+}
+
+#endif
@@ -6,13 +6,33 @@
 
 namespace pinta {
 
+// Paces the frames to a given rate. When a frame takes longer than its
+// interval the policy decides what happens to the deadlines that passed:
+// CATCH_UP keeps them, so the next ticks return at once until the clock is
+// back on time; DROP skips them and waits for the next deadline on time;
+// REANCHOR starts counting the intervals again from the late tick.
+//
+// If the display already waits for the vertical sync on swap, the clock must
+// not sleep too, and only measures the time of the frames.
 class Clock {
 
 public:
 
-    Clock(double fps);
+    enum Policy {
+        CATCH_UP,
+        DROP,
+        REANCHOR
+    };
 
-    void tick();
+    Clock(double fps, Policy policy = CATCH_UP);
+
+    inline double getDelta() const {return delta / double(NANOSECONDS_PER_SECOND);}
+    inline unsigned long getDroppedFrames() const {return droppedFrames;}
+    inline Policy getPolicy() const {return policy;}
+    inline bool isVsyncEnabled() const {return vsync;}
+    inline void setPolicy(Policy policy) {this->policy = policy;}
+    inline void setVsync(bool vsync) {this->vsync = vsync;}
+    double tick();
 
 private:
 
@@ -20,9 +40,17 @@ private:
     static const clockid_t CLOCK;
 
     static inline uint64_t asNanoseconds(struct timespec ts) {return ts.tv_sec * NANOSECONDS_PER_SECOND + ts.tv_nsec;}
+    static uint64_t now();
 
     uint64_t interval;
     uint64_t lastTimestamp;
+    uint64_t lastTick;
+    uint64_t delta;
+    unsigned long droppedFrames;
+    Policy policy;
+    bool vsync;
+    // Whether the previous tick was already behind its deadline
+    bool behind;
 
 };
 
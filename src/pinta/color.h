@@ -13,6 +13,8 @@ public:
     Color(const Color &other);
 
     const Color & operator=(const Color &other);
+    inline bool operator==(const Color &other) const {return r == other.r && g == other.g && b == other.b && a == other.a;}
+    inline bool operator!=(const Color &other) const {return !(*this == other);}
 
     inline uint8_t getRed() const {return r;}
     inline uint8_t getGreen() const {return g;}
@@ -0,0 +1,121 @@
+#ifndef PINTA_COMMANDLIST_H
+#define PINTA_COMMANDLIST_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "pinta/drawlist.h"
+#include "pinta/mesh.h"
+#include "pinta/meshbatch.h"
+#include "pinta/meshhandle.h"
+#include "pinta/meshstore.h"
+#include "pinta/renderer.h"
+#include "pinta/scene.h"
+#include "pinta/sdfshape.h"
+
+namespace pinta {
+
+// The calls to a Renderer for one frame, recorded to be replayed later,
+// usually on another thread (see RenderThread). Draw lists are copied, or
+// moved in without a copy, but not their meshes: the meshes and animations
+// of the items, and the clip masks, must not change until the frame is
+// drawn. The same goes for batches and stores, whose shapes and handles are
+// copied, and for scenes, which the renderer also updates when it draws
+// them. Meshes given to keep are owned by the list until it is reset, so a
+// mesh can be handed over to the renderer and dropped.
+class CommandList {
+
+public:
+
+    CommandList();
+
+    void clear();
+    void draw(const DrawList &drawList);
+    // Takes the items of the list, which is left empty but keeps the memory
+    // of a list recorded before, so that it is reused for the next frame
+    void draw(DrawList &&drawList);
+    void draw(Scene &scene);
+    void draw(const MeshStore &store, const MeshHandle *handles, size_t count);
+    void draw(const MeshBatch &batch);
+    void draw(const SdfShape *shapes, size_t count);
+    inline bool isEmpty() const {return commands.empty();}
+    void keep(std::shared_ptr<const Mesh> mesh);
+    void popClip();
+    void popTransform();
+    void pushClip(const BoundingBox &area);
+    void pushClip(const Mesh *mask);
+    void pushTransform();
+    void release(const Mesh *mesh);
+    void release(const MeshStore *store);
+    void release(const MeshBatch *batch);
+    void replay(Renderer &renderer) const;
+    void reset();
+    void resetTransformations();
+    void rotate(float angle);
+    void scale(const glm::vec2 &scaleFactor);
+    void setBackgroundColor(const glm::vec3 &color);
+    // Limits the whole frame to the damage, even when it is recorded last,
+    // after DamageTracker::update has seen the list
+    void setDamage(const BoundingBox &area);
+    void setTime(float time);
+    void translate(const glm::vec2 &position);
+
+private:
+
+    friend class DamageTracker;
+
+    enum Type {
+        CLEAR,
+        DRAW,
+        DRAW_BATCH,
+        DRAW_SCENE,
+        DRAW_SHAPES,
+        DRAW_STORE,
+        POP_CLIP,
+        POP_TRANSFORM,
+        PUSH_CLIP,
+        PUSH_TRANSFORM,
+        RELEASE_BATCH,
+        RELEASE_MESH,
+        RELEASE_STORE,
+        RESET_TRANSFORMATIONS,
+        ROTATE,
+        SCALE,
+        SET_BACKGROUND_COLOR,
+        SET_DAMAGE,
+        SET_TIME,
+        TRANSLATE
+    };
+
+    struct Command {
+        Type type;
+        glm::vec3 value;
+        size_t drawList;
+        BoundingBox area;
+        // The clip mask, or the released mesh
+        const Mesh *mask;
+        const MeshBatch *batch;
+        const MeshStore *store;
+        Scene *scene;
+        // The shapes or handles drawn, in the arrays of the list
+        size_t first;
+        size_t count;
+    };
+
+    void add(Type type, const glm::vec3 &value = glm::vec3(0.0, 0.0, 0.0), size_t drawList = 0);
+
+    std::vector<Command> commands;
+    // Draw lists are kept between frames so that their items are reused
+    std::vector<DrawList> drawLists;
+    size_t drawListCount;
+    std::vector<std::shared_ptr<const Mesh>> meshes;
+    std::vector<SdfShape> shapes;
+    std::vector<MeshHandle> handles;
+
+};
+
+}
+
+#endif
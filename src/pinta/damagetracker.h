@@ -0,0 +1,74 @@
+#ifndef PINTA_DAMAGETRACKER_H
+#define PINTA_DAMAGETRACKER_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "pinta/boundingbox.h"
+#include "pinta/commandlist.h"
+#include "pinta/transform2d.h"
+
+namespace pinta {
+
+// Finds the part of the window that a frame changes, by comparing what the
+// items of its command list look like with the previous frame: the items
+// that appeared, disappeared, moved or changed damage their bounds, in the
+// previous frame and in this one. The damage is a single rectangle in window
+// pixels, to be given to Renderer::setDamage before the list is replayed:
+//
+//     renderer.setDamage(damage.update(commands));
+//     commands.replay(renderer);
+//
+// Only the damage is drawn again, so the display must keep the contents of
+// the previous frame (see Display::keepsContents). Items with a
+// ShaderAnimation are damaged whenever the time changes. Batches, stores and
+// scenes are not followed, so a frame that draws one of them is damaged
+// whole.
+class DamageTracker {
+
+public:
+
+    DamageTracker(int width, int height);
+
+    inline const BoundingBox & getDamage() const {return damage;}
+    // Damages the whole window on the next update, when the contents of the
+    // display have been lost
+    inline void invalidate() {invalid = true;}
+    const BoundingBox & update(const CommandList &commands);
+
+private:
+
+    struct Record {
+        uint64_t key;
+        BoundingBox bounds;
+    };
+
+    struct Clip {
+        BoundingBox bounds;
+        uint64_t key;
+    };
+
+    BoundingBox getWindowBounds(const BoundingBox &bounds, const Transform2D &transform) const;
+    void record(const DrawItem &item, const Transform2D &modelview, const Clip &clip, size_t drawList);
+    void record(const SdfShape &shape, const Transform2D &modelview, const Clip &clip, size_t index);
+
+    int width;
+    int height;
+    Transform2D projection;
+    // The state of the renderer as the commands leave it
+    Transform2D transformation;
+    std::vector<Transform2D> transformStack;
+    std::vector<Clip> clips;
+    float time;
+    glm::vec3 backgroundColor;
+    std::vector<Record> records;
+    std::vector<Record> previousRecords;
+    BoundingBox damage;
+    bool invalid;
+
+};
+
+}
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <SDL2/SDL.h>
 
+#include "pinta/boundingbox.h"
+
 namespace pinta {
 
 class Display {
@@ -14,16 +16,29 @@ public:
 
     inline int getWidth() const {return width;}
     inline int getHeight() const {return height;}
-
+    // Whether swap waits for the vertical sync, see Clock::setVsync
+    inline bool isVsyncEnabled() const {return vsync;}
+    // Whether the window keeps what was drawn in the previous frame, so that
+    // only the damage of a frame needs to be drawn (see DamageTracker)
+    inline bool keepsContents() const {return preserved;}
+    // Makes the GL context current on the calling thread, or releases it
+    void makeCurrent(bool current);
     void swap();
+    // Presents a frame that only changed inside the damage, in window pixels,
+    // which the window system may use to update less of the screen
+    void swap(const BoundingBox &damage);
 
 private:
 
+    bool createWindow(const char *title);
     void init(const char *title);
 
     int width;
     int height;
     SDL_Window *window;
+    SDL_GLContext context;
+    bool vsync;
+    bool preserved;
 
 };
 
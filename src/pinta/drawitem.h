@@ -0,0 +1,43 @@
+#ifndef PINTA_DRAWITEM_H
+#define PINTA_DRAWITEM_H
+
+#include <glm/glm.hpp>
+
+#include "pinta/color.h"
+#include "pinta/drawstate.h"
+#include "pinta/lodshape.h"
+#include "pinta/mesh.h"
+#include "pinta/shaderanimation.h"
+
+namespace pinta {
+
+class DrawItem {
+
+public:
+
+    DrawItem(const Mesh *mesh, const glm::vec2 &position, const glm::vec2 &scale, const DrawState &state, int layer,
+        const Color &color, const ShaderAnimation *animation = nullptr);
+    DrawItem(const LodShape *shape, const glm::vec2 &position, const glm::vec2 &scale, const DrawState &state, int layer,
+        const Color &color, const ShaderAnimation *animation = nullptr);
+
+    // Whether the item is drawn before the other one by Renderer::draw: by
+    // layer, then by state, position, scale, color and animation to batch
+    // the most meshes. Items equal in all of these are drawn in the order of
+    // their meshes in the buffers.
+    bool isDrawnBefore(const DrawItem &other) const;
+
+    // The mesh of the item, or the shape whose level of detail is drawn
+    const Mesh *mesh;
+    const LodShape *shape;
+    glm::vec2 position;
+    glm::vec2 scale;
+    DrawState state;
+    int layer;
+    Color color;
+    const ShaderAnimation *animation;
+
+};
+
+}
+
+#endif
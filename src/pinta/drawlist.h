@@ -0,0 +1,51 @@
+#ifndef PINTA_DRAWLIST_H
+#define PINTA_DRAWLIST_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "pinta/color.h"
+#include "pinta/drawitem.h"
+#include "pinta/drawstate.h"
+#include "pinta/lodshape.h"
+#include "pinta/mesh.h"
+#include "pinta/shaderanimation.h"
+
+namespace pinta {
+
+// The items of a frame. Layers are drawn in increasing order, but the items
+// inside a layer may be reordered to reduce the changes of state, so items
+// that overlap must be put in different layers. The color of an item is
+// multiplied by the colors of the vertices of its mesh, so that meshes shared
+// between items (see sharedRectangle) can be drawn in different colors. Items
+// that share a ShaderAnimation are animated by the GPU. The items can be
+// changed in place, for instance by an AnimationEngine, through getItem;
+// references to them stay valid until items are added past the reserved
+// size, or the list is cleared.
+class DrawList {
+
+public:
+
+    DrawList();
+
+    void add(const Mesh *mesh, const glm::vec2 &position = glm::vec2(0.0, 0.0),
+        const glm::vec2 &scale = glm::vec2(1.0, 1.0), const DrawState &state = DrawState(), int layer = 0,
+        const Color &color = Color(255, 255, 255), const ShaderAnimation *animation = nullptr);
+    void add(const LodShape *shape, const glm::vec2 &position = glm::vec2(0.0, 0.0),
+        const glm::vec2 &scale = glm::vec2(1.0, 1.0), const DrawState &state = DrawState(), int layer = 0,
+        const Color &color = Color(255, 255, 255), const ShaderAnimation *animation = nullptr);
+    void clear();
+    inline DrawItem & getItem(size_t index) {return items[index];}
+    inline const std::vector<DrawItem> & getItems() const {return items;}
+    inline void reserve(size_t size) {items.reserve(size);}
+
+private:
+
+    std::vector<DrawItem> items;
+
+};
+
+}
+
+#endif
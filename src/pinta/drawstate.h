@@ -0,0 +1,30 @@
+#ifndef PINTA_DRAWSTATE_H
+#define PINTA_DRAWSTATE_H
+
+namespace pinta {
+
+class DrawState {
+
+public:
+
+    DrawState(bool stencilTest = false, bool updateStencil = false, bool updateColor = true);
+
+    bool operator==(const DrawState &other) const;
+    inline bool operator!=(const DrawState &other) const {return !(*this == other);}
+
+    int getSortKey() const;
+    inline bool isStencilTestEnabled() const {return stencilTest;}
+    inline bool isUpdateColorEnabled() const {return updateColor;}
+    inline bool isUpdateStencilEnabled() const {return updateStencil;}
+
+private:
+
+    bool stencilTest;
+    bool updateStencil;
+    bool updateColor;
+
+};
+
+}
+
+#endif
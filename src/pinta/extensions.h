@@ -0,0 +1,12 @@
+#ifndef PINTA_EXTENSIONS_H
+#define PINTA_EXTENSIONS_H
+
+namespace pinta {
+
+// Whether the name is one of the extensions of a space separated list, such
+// as the ones of glGetString or eglQueryString. The list may be null.
+bool hasExtension(const char *extensions, const char *name);
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef PINTA_FRAMESTATS_H
+#define PINTA_FRAMESTATS_H
+
+#include <cstdint>
+
+namespace pinta {
+
+// The counters and the CPU time of the phases of a frame, or of several
+// frames added together.
+class FrameStats {
+
+public:
+
+    enum Counter {
+        DRAW_CALLS,
+        BUFFER_UPLOADS,
+        BYTES_UPLOADED,
+        FULL_REBUILDS,
+        UNIFORM_CHANGES,
+        STATE_CHANGES,
+        MISSED_DEADLINES,
+        ELIDED_CALLS,
+        DAMAGED_PIXELS,
+        COUNTERS
+    };
+
+    enum Phase {
+        TESSELLATE,
+        UPLOAD,
+        SUBMIT,
+        SWAP,
+        PHASES
+    };
+
+    FrameStats();
+
+    inline void add(Counter counter, uint64_t amount) {counters[counter] += amount;}
+    void add(const FrameStats &other);
+    inline void addPhaseTime(Phase phase, uint64_t nanoseconds) {phaseTimes[phase] += nanoseconds;}
+    void clear();
+    inline uint64_t getCounter(Counter counter) const {return counters[counter];}
+    static const char * getCounterName(Counter counter);
+    static const char * getPhaseName(Phase phase);
+    inline uint64_t getPhaseTime(Phase phase) const {return phaseTimes[phase];}
+
+private:
+
+    uint64_t counters[COUNTERS];
+    uint64_t phaseTimes[PHASES];
+
+};
+
+}
+
+#endif
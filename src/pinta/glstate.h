@@ -0,0 +1,82 @@
+#ifndef PINTA_GLSTATE_H
+#define PINTA_GLSTATE_H
+
+#include <GLES2/gl2.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace pinta {
+
+// A copy of the GL state set through it, so that calls that would not change
+// anything are not sent to the driver. Everything that changes the tracked
+// state must go through the same GLState, or it must be reset. After a reset
+// the state is unknown and the next call of each kind is always sent.
+class GLState {
+
+public:
+
+    static const int MAX_ATTRIBUTES = 4;
+
+    GLState();
+
+    void bindBuffer(GLenum target, GLuint buffer);
+    void colorMask(bool update);
+    void deleteBuffer(GLuint buffer);
+    void enable(GLenum capability, bool enable);
+    inline unsigned long getElidedCalls() const {return elidedCalls;}
+    void reset();
+    void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+    void stencilFunc(GLenum function, GLint reference, GLuint mask);
+    void stencilOp(GLenum fail, GLenum depthFail, GLenum pass);
+    // The bits of the stencil that are written
+    void stencilWriteMask(GLuint mask);
+    void uniform(GLint location, GLfloat value);
+    void uniform(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+    void uniformVectors(GLint location, GLsizei count, const GLfloat *vectors);
+    void useProgram(GLuint program);
+    void vertexAttrib(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+    void vertexAttribArray(GLuint index, bool enable);
+    void vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+        const void *pointer);
+
+private:
+
+    struct Attribute {
+        int enabled;
+        GLuint buffer;
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        GLsizei stride;
+        const void *pointer;
+        GLfloat value[4];
+    };
+
+    static const GLuint UNKNOWN;
+
+    bool changeUniform(GLint location, GLsizei size, const GLfloat *values);
+
+    GLuint program;
+    GLuint arrayBuffer;
+    GLuint elementArrayBuffer;
+    Attribute attributes[MAX_ATTRIBUTES];
+    int blend;
+    int scissorTest;
+    GLint scissorBox[4];
+    int stencilTest;
+    GLenum stencilFunction;
+    GLint stencilReference;
+    GLuint stencilMask;
+    GLenum stencilOps[3];
+    GLuint stencilWrites;
+    int colorMaskEnabled;
+    // The values of the uniforms of each program, by program and location
+    std::unordered_map<uint64_t, std::vector<GLfloat>> uniforms;
+    unsigned long elidedCalls;
+
+};
+
+}
+
+#endif
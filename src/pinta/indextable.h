@@ -0,0 +1,48 @@
+#ifndef PINTA_INDEXTABLE_H
+#define PINTA_INDEXTABLE_H
+
+#include <cstddef>
+#include <vector>
+
+namespace pinta {
+
+// Maps pointers to indices, for instance of the elements of arrays kept in
+// parallel. The entries are kept in a single array with open addressing, so
+// that adding and removing them doesn't allocate until the table grows.
+class IndexTable {
+
+public:
+
+    // What find returns for the keys that aren't in the table
+    static const size_t NONE;
+
+    IndexTable();
+
+    void clear();
+    void erase(const void *key);
+    size_t find(const void *key) const;
+    inline size_t getSize() const {return size;}
+    // Adds the key, or changes its index if it is already in the table
+    void insert(const void *key, size_t index);
+    void reserve(size_t count);
+
+private:
+
+    struct Entry {
+        const void *key;
+        size_t index;
+    };
+
+    size_t getSlot(const void *key) const;
+    void rehash(size_t capacity);
+
+    // Null keys mark the free entries. The capacity is a power of two, and
+    // at most half of it is used.
+    std::vector<Entry> entries;
+    size_t size;
+
+};
+
+}
+
+#endif
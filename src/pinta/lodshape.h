@@ -0,0 +1,65 @@
+#ifndef PINTA_LODSHAPE_H
+#define PINTA_LODSHAPE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <glm/glm.hpp>
+
+#include "pinta/mesh.h"
+#include "pinta/shapedescription.h"
+#include "pinta/transform2d.h"
+
+namespace pinta {
+
+// A circle or a rectangle tessellated as finely as its size on the screen
+// needs: the edge of the mesh is never further than the tolerance, in
+// pixels, from the curve. The segments of the levels of detail are powers
+// of two, so the mesh only changes when the zoom crosses a level, and each
+// level is tessellated on first use and kept. The segments of the
+// description are ignored. Draw it with DrawList::add, the renderer picks
+// the level from the transformation. The levels can be taken from several
+// threads at once.
+class LodShape {
+
+public:
+
+    static const int LEVELS = 7;
+    static const float DEFAULT_TOLERANCE;
+
+    LodShape(const ShapeDescription &shape, float tolerance = DEFAULT_TOLERANCE);
+    LodShape(const LodShape &other) = delete;
+
+    const LodShape & operator=(const LodShape &other) = delete;
+
+    // The level for a scale in pixels per unit of the shape
+    inline int getLevel(float pixelScale) const {return levelFor(pixelScale, tolerance);}
+    // The mesh for a scale in pixels per unit of the shape
+    const Mesh * getMesh(float pixelScale) const;
+    // The mesh for an item of the given scale drawn with a modelview
+    // transformation into a viewport of the given size in pixels
+    const Mesh * getMesh(const Transform2D &modelview, const glm::vec2 &scale, int viewportWidth,
+        int viewportHeight) const;
+    const Mesh * getMeshOfLevel(int level) const;
+    inline const ShapeDescription & getShape() const {return shape;}
+    // The segments of a circle, or of each corner of a rectangle
+    int getSegments(int level) const;
+    inline float getTolerance() const {return tolerance;}
+    // The coarsest level within a tolerance in pixels at a scale in pixels
+    // per unit of the shape
+    int levelFor(float pixelScale, float tolerance) const;
+
+private:
+
+    ShapeDescription shape;
+    float tolerance;
+    // The levels made so far, read without the lock
+    mutable std::atomic<const Mesh *> levels[LEVELS];
+    mutable std::unique_ptr<Mesh> meshes[LEVELS];
+    mutable std::mutex mutex;
+
+};
+
+}
+
+#endif
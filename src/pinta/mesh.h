@@ -1,33 +1,60 @@
 #ifndef PINTA_MESH_H
 #define PINTA_MESH_H
 
+#include "boundingbox.h"
 #include "vertex.h"
 
 #include <GLES2/gl2.h>
+#include <atomic>
+#include <memory>
 #include <vector>
 
 namespace pinta {
 
+// Every change to a mesh gives it a new generation, unique among all the
+// meshes, so that meshes with the same generation have the same contents.
+// Indices are 32 bit, so that a mesh can have more than 65536 vertices.
+// They used to be 16 bit: code that keeps them in a std::vector<GLushort>
+// has to copy them to a std::vector<GLuint> for setIndices.
 class Mesh {
 
 public:
 
     Mesh(GLenum primitive);
+    // A copy has the contents of the mesh, but no scene watches it
+    Mesh(const Mesh &other);
 
-    inline GLushort getIndexCount() const {return indices.size();}
-    inline const std::vector<GLushort> & getIndices() const {return indices;}
+    const Mesh & operator=(const Mesh &other);
+
+    inline const BoundingBox & getBounds() const {return bounds;}
+    inline unsigned int getGeneration() const {return generation;}
+    inline GLsizei getIndexCount() const {return indices.size();}
+    inline unsigned int getIndexGeneration() const {return indexGeneration;}
+    inline const std::vector<GLuint> & getIndices() const {return indices;}
     inline GLenum getPrimitive() const {return primitive;}
     inline const std::vector<Vertex> & getVertices() const {return vertices;}
     void setColor(const Color &color);
-    inline void setIndices(const std::vector<GLushort> &indices) {this->indices = indices;}
-    inline void setPrimitive(GLenum primitive) {this->primitive = primitive;}
-    inline void setVertices(const std::vector<Vertex> &vertices) {this->vertices = vertices;}
+    void setIndices(const std::vector<GLuint> &indices);
+    void setPrimitive(GLenum primitive);
+    void setVertices(const std::vector<Vertex> &vertices);
 
 private:
 
+    friend class Scene;
+
+    static std::atomic<unsigned int> nextGeneration;
+
+    void notifyChange();
+
     GLenum primitive;
     std::vector<Vertex> vertices;
-    std::vector<GLushort> indices;
+    std::vector<GLuint> indices;
+    BoundingBox bounds;
+    unsigned int generation;
+    unsigned int indexGeneration;
+    // The lists of changed meshes of the scenes that have drawn it, which
+    // may be destroyed first
+    mutable std::vector<std::weak_ptr<std::vector<const Mesh *>>> changeLists;
 
 };
 
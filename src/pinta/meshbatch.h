@@ -0,0 +1,56 @@
+#ifndef PINTA_MESHBATCH_H
+#define PINTA_MESHBATCH_H
+
+#include <GLES2/gl2.h>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "pinta/mesh.h"
+#include "pinta/shapedescription.h"
+#include "pinta/threadpool.h"
+#include "pinta/vertex.h"
+
+namespace pinta {
+
+// Meshes tessellated together into a single array of vertices and a single
+// array of indices, see tessellate. The indices of each mesh count from its
+// first vertex. The arrays are reused by the next tessellation of the batch,
+// which gives the batch a new generation, unique among all the batches. The
+// arrays are ready to upload as they are, see Renderer::draw(const MeshBatch &).
+class MeshBatch {
+
+public:
+
+    MeshBatch();
+
+    Mesh * createMesh(size_t mesh) const;
+    inline size_t getFirstIndex(size_t mesh) const {return firstIndices[mesh];}
+    inline size_t getFirstVertex(size_t mesh) const {return firstVertices[mesh];}
+    inline unsigned int getGeneration() const {return generation;}
+    inline size_t getIndexCount(size_t mesh) const {return firstIndices[mesh + 1] - firstIndices[mesh];}
+    inline const std::vector<GLuint> & getIndices() const {return indices;}
+    inline GLenum getPrimitive(size_t mesh) const {return primitives[mesh];}
+    inline size_t getSize() const {return primitives.size();}
+    inline size_t getVertexCount(size_t mesh) const {return firstVertices[mesh + 1] - firstVertices[mesh];}
+    inline const std::vector<Vertex> & getVertices() const {return vertices;}
+
+private:
+
+    friend void tessellate(const std::vector<ShapeDescription> &shapes, MeshBatch &batch, ThreadPool &pool);
+
+    static std::atomic<unsigned int> nextGeneration;
+
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<GLenum> primitives;
+    // One more than the meshes, so that the last one ends where the arrays end
+    std::vector<size_t> firstVertices;
+    std::vector<size_t> firstIndices;
+    unsigned int generation;
+
+};
+
+}
+
+#endif
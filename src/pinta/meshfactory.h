@@ -1,13 +1,28 @@
 #ifndef PINTA_MESHFACTORY_H
 #define PINTA_MESHFACTORY_H
 
+#include <memory>
+#include <vector>
+
 #include "pinta/color.h"
 #include "pinta/mesh.h"
+#include "pinta/meshbatch.h"
+#include "pinta/shapedescription.h"
+#include "pinta/tessellationcache.h"
 
 namespace pinta {
 
 Mesh * rectangle(float w, float h, float cornerRadius = 0, const Color &color = Color(0, 0, 0), int segments = 16);
 Mesh * circle(float radius, const Color &color = Color(0, 0, 0), int segments = 32);
+// Tessellates a single shape, without the tessellation cache
+Mesh * createMesh(const ShapeDescription &shape);
+std::shared_ptr<const Mesh> sharedRectangle(float w, float h, float cornerRadius = 0, int segments = 16);
+std::shared_ptr<const Mesh> sharedCircle(float radius, int segments = 32);
+TessellationCache & tessellationCache();
+// Tessellates the shapes in parallel into the batch, in the same order. The
+// tessellation cache is not used.
+void tessellate(const std::vector<ShapeDescription> &shapes, MeshBatch &batch);
+void tessellate(const std::vector<ShapeDescription> &shapes, MeshBatch &batch, ThreadPool &pool);
 
 }
 
@@ -0,0 +1,27 @@
+#ifndef PINTA_MESHHANDLE_H
+#define PINTA_MESHHANDLE_H
+
+#include <cstdint>
+
+namespace pinta {
+
+// Refers to a mesh in a MeshStore. The generation tells apart the meshes that
+// took the same slot of the store, so that the handles of destroyed meshes
+// don't refer to the meshes created after them.
+class MeshHandle {
+
+public:
+
+    MeshHandle(uint32_t index = 0, uint32_t generation = 0);
+
+    inline bool operator==(const MeshHandle &other) const {return index == other.index && generation == other.generation;}
+    inline bool operator!=(const MeshHandle &other) const {return !(*this == other);}
+
+    uint32_t index;
+    uint32_t generation;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef PINTA_MESHSTORE_H
+#define PINTA_MESHSTORE_H
+
+#include <GLES2/gl2.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "pinta/boundingbox.h"
+#include "pinta/color.h"
+#include "pinta/mesh.h"
+#include "pinta/meshhandle.h"
+#include "pinta/vertex.h"
+
+namespace pinta {
+
+// Keeps meshes in slots addressed by handles, with the vertices of all of them
+// in a single array and their indices in another, like a MeshBatch. The
+// indices of each mesh count from its first vertex. The slots of destroyed
+// meshes are reused, and their handles become invalid. A mesh that changes
+// size moves to the end of the arrays, and the arrays are compacted once half
+// of them is left unused, so the pointers to the vertices and indices of a
+// mesh are only valid until the next change to the store. The getters need a
+// valid handle.
+class MeshStore {
+
+public:
+
+    MeshStore();
+
+    MeshHandle add(const Mesh &mesh);
+    MeshHandle add(GLenum primitive, const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices);
+    void clear();
+    Mesh * createMesh(MeshHandle handle) const;
+    void destroy(MeshHandle handle);
+    inline const BoundingBox & getBounds(MeshHandle handle) const {return slots[handle.index].bounds;}
+    inline uint32_t getCapacity() const {return slots.size();}
+    // Every change to a mesh gives it a new generation, unique among all the
+    // meshes of all the stores
+    inline unsigned int getGeneration(MeshHandle handle) const {return slots[handle.index].generation;}
+    inline size_t getIndexCount(MeshHandle handle) const {return slots[handle.index].indexCount;}
+    inline unsigned int getIndexGeneration(MeshHandle handle) const {return slots[handle.index].indexGeneration;}
+    inline const GLuint * getIndices(MeshHandle handle) const {return indices.data() + slots[handle.index].firstIndex;}
+    inline GLenum getPrimitive(MeshHandle handle) const {return slots[handle.index].primitive;}
+    inline uint32_t getSize() const {return slots.size() - freeSlots.size();}
+    inline size_t getVertexCount(MeshHandle handle) const {return slots[handle.index].vertexCount;}
+    inline const Vertex * getVertices(MeshHandle handle) const {return vertices.data() + slots[handle.index].firstVertex;}
+    inline bool isValid(MeshHandle handle) const {
+        return handle.index < handles.size() && handles[handle.index] == handle.generation && handle.generation % 2;
+    }
+    void setColor(MeshHandle handle, const Color &color);
+    void setIndices(MeshHandle handle, const std::vector<GLuint> &indices);
+    void setPrimitive(MeshHandle handle, GLenum primitive);
+    void setVertices(MeshHandle handle, const std::vector<Vertex> &vertices);
+
+private:
+
+    struct Slot {
+        GLenum primitive;
+        BoundingBox bounds;
+        size_t firstVertex;
+        size_t vertexCount;
+        size_t firstIndex;
+        size_t indexCount;
+        unsigned int generation;
+        unsigned int indexGeneration;
+    };
+
+    static std::atomic<unsigned int> nextGeneration;
+
+    void compact();
+
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<Slot> slots;
+    // The generations of the handles of each slot, odd for the slots in use
+    std::vector<uint32_t> handles;
+    std::vector<uint32_t> freeSlots;
+    // The parts of the arrays left by meshes that were moved or destroyed
+    size_t unusedVertices;
+    size_t unusedIndices;
+
+};
+
+}
+
+#endif
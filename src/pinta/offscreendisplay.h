@@ -0,0 +1,58 @@
+#ifndef PINTA_OFFSCREENDISPLAY_H
+#define PINTA_OFFSCREENDISPLAY_H
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <cstdint>
+#include <vector>
+
+#include "pinta/boundingbox.h"
+
+namespace pinta {
+
+// A display without a window, for machines without a GPU or a window system.
+// The GLES2 context is created on the EGL surfaceless platform if there is
+// one, or on a pbuffer otherwise, and everything is drawn into a framebuffer
+// object of the size of the display. Each swap ends a frame.
+class OffscreenDisplay {
+
+public:
+
+    OffscreenDisplay(int width, int height);
+    OffscreenDisplay(const OffscreenDisplay &other) = delete;
+    ~OffscreenDisplay();
+
+    const OffscreenDisplay & operator=(const OffscreenDisplay &other) = delete;
+
+    inline unsigned long getFrame() const {return frame;}
+    inline int getHeight() const {return height;}
+    inline int getWidth() const {return width;}
+    // The framebuffer object is never cleared by a swap
+    inline bool keepsContents() const {return true;}
+    // Makes the GL context current on the calling thread, or releases it
+    void makeCurrent(bool current);
+    void readPixels(std::vector<uint8_t> &pixels) const;
+    void swap();
+    inline void swap(const BoundingBox &) {swap();}
+
+private:
+
+    void init();
+    void initFramebuffer();
+    void release();
+
+    int width;
+    int height;
+    EGLDisplay display;
+    EGLSurface surface;
+    EGLContext context;
+    GLuint framebuffer;
+    GLuint colorTexture;
+    GLuint stencilBuffer;
+    unsigned long frame;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef PINTA_PATH_H
+#define PINTA_PATH_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace pinta {
+
+// A sequence of contours made of lines and Bezier curves, to be filled or
+// stroked by a PathTessellator. A contour starts at moveTo, or at the start
+// of the previous one after close; drawing without a current point starts
+// a contour at the first point given. Arcs are kept as cubic curves.
+class Path {
+
+public:
+
+    enum Verb {
+        MOVE,
+        LINE,
+        QUAD,
+        CUBIC,
+        CLOSE
+    };
+
+    Path();
+
+    // Counterclockwise from startAngle to endAngle in radians, clockwise if
+    // endAngle is smaller. A line joins the current point to the start.
+    void arc(const glm::vec2 &center, float radius, float startAngle, float endAngle);
+    void clear();
+    void close();
+    void cubicTo(const glm::vec2 &control1, const glm::vec2 &control2, const glm::vec2 &point);
+    // The points of the verbs in order: one for a move or a line, two for a
+    // quadratic curve, three for a cubic curve and none for a close
+    inline const std::vector<glm::vec2> & getPoints() const {return points;}
+    inline const std::vector<Verb> & getVerbs() const {return verbs;}
+    inline bool isEmpty() const {return verbs.empty();}
+    void lineTo(const glm::vec2 &point);
+    void moveTo(const glm::vec2 &point);
+    void quadTo(const glm::vec2 &control, const glm::vec2 &point);
+    void reserve(size_t verbs, size_t points);
+
+private:
+
+    void ensureContour(const glm::vec2 &point);
+
+    std::vector<Verb> verbs;
+    std::vector<glm::vec2> points;
+    // The first point of the current contour, in points
+    size_t contourStart;
+    bool hasCurrentPoint;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef PINTA_PATHTESSELLATOR_H
+#define PINTA_PATHTESSELLATOR_H
+
+#include <GLES2/gl2.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "pinta/color.h"
+#include "pinta/path.h"
+#include "pinta/strokestyle.h"
+#include "pinta/vertex.h"
+
+namespace pinta {
+
+// Turns paths into triangles, appended to vertices and indices given by the
+// caller so that many paths can go into a single GL_TRIANGLES mesh:
+//
+//     vertices.clear();
+//     indices.clear();
+//     tessellator.stroke(chart, StrokeStyle(2.0), color, vertices, indices);
+//     mesh.setVertices(vertices);
+//     mesh.setIndices(indices);
+//
+// The indices count from the first of the vertices. Curves are split into
+// lines no further than the tolerance from them. The working memory of the
+// tessellator and the arrays given to it are reused by the next paths, so
+// once they have grown large enough no memory is allocated.
+class PathTessellator {
+
+public:
+
+    static const float DEFAULT_TOLERANCE;
+
+    PathTessellator(float tolerance = DEFAULT_TOLERANCE);
+
+    // Fills each contour of the path by ear clipping. The contours are filled
+    // on their own: overlapping contours add up, and holes are not cut out.
+    void fill(const Path &path, const Color &color, std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+    inline float getTolerance() const {return tolerance;}
+    inline void setTolerance(float tolerance) {this->tolerance = tolerance;}
+    void stroke(const Path &path, const StrokeStyle &style, const Color &color, std::vector<Vertex> &vertices,
+        std::vector<GLuint> &indices);
+
+private:
+
+    // The points of a flattened contour, without repeated points
+    struct Contour {
+        size_t first;
+        size_t count;
+        bool closed;
+    };
+
+    static const int MAX_CURVE_SEGMENTS;
+
+    void addArc(const glm::vec2 &center, GLuint centerVertex, const glm::vec2 &from, float angle, GLuint first,
+        GLuint last, const Color &color, std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+    void addJoin(const glm::vec2 &point, const glm::vec2 &before, const glm::vec2 &after, GLuint beforeVertices,
+        GLuint afterVertices, const StrokeStyle &style, const Color &color, std::vector<Vertex> &vertices,
+        std::vector<GLuint> &indices);
+    void addPoint(const glm::vec2 &point);
+    void clipEars(const Contour &contour, GLuint base, std::vector<GLuint> &indices);
+    void finishContour(bool close);
+    void flatten(const Path &path, bool closeAll);
+    static int getCurveSegments(float segments);
+    // Positive where the polygon turns the same way as its whole contour
+    float getTurn(int point) const;
+    bool isEar(int ear) const;
+
+    float tolerance;
+    std::vector<glm::vec2> points;
+    std::vector<Contour> contours;
+    // The polygon left to clip, as a list around the points of a contour
+    std::vector<int> previous;
+    std::vector<int> next;
+    std::vector<uint8_t> reflex;
+    // The reflex points of the polygon sorted by the cells of a grid over it,
+    // the only ones that can be inside an ear
+    std::vector<int> cellStarts;
+    std::vector<int> cellPoints;
+    glm::vec2 gridOrigin;
+    float cellSize;
+    int gridSize;
+    float orientation;
+    const glm::vec2 *polygon;
+
+};
+
+}
+
+#endif
@@ -2,8 +2,10 @@
 #define PINTA_RENDEREDMESH_H
 
 #include <GLES2/gl2.h>
+#include <cstddef>
+#include <vector>
 
-#include "pinta/mesh.h"
+#include "pinta/color.h"
 #include "pinta/vertex.h"
 
 namespace pinta {
@@ -12,24 +14,78 @@ class RenderedMesh {
 
 public:
 
+    // Layouts of the vertices in the vertex buffers. Packed positions are
+    // fixed point numbers with POSITION_SCALE steps per unit.
+    enum Format {
+        FULL,
+        PACKED_COLOR,
+        PACKED,
+        FORMATS
+    };
+
+    static const float POSITION_SCALE;
+
     RenderedMesh();
-    RenderedMesh(const Mesh *mesh, int vertexOffset, int indexOffset);
+    // The generations are those of the mesh, and 0 for the meshes of a
+    // MeshBatch
+    RenderedMesh(unsigned int generation, unsigned int indexGeneration, GLenum primitive, Format format, const Color &color,
+        int vertexBase, int vertexOffset, int vertexCount, int indexOffset, int indexCount);
     RenderedMesh(const RenderedMesh &other);
     ~RenderedMesh();
 
-    inline const void * getColorOffset() const {return (const void *)(vertexOffset * sizeof(Vertex) + sizeof(float) * 2);}
-    inline const void * getIndexOffset() const {return (const void *)(indexOffset * sizeof(unsigned short));}
-    inline const void * getPositionOffset() const {return (const void *)(vertexOffset * sizeof(Vertex));}
-    GLsizei getStride() const {return sizeof(Vertex);}
+    const RenderedMesh & operator=(const RenderedMesh &other);
+
+    static GLsizei getVertexSize(Format format);
+
+    // Meshes that don't fit in a page of the vertex buffer are split in
+    // parts, each one with its own slices. The vertex of the mesh that each
+    // vertex of the parts comes from is kept, part after part, so that the
+    // parts are updated in place when only the vertices change.
+    inline void addPart(const RenderedMesh &part, const std::vector<GLuint> &sources) {
+        parts.push_back(part);
+        sourceVertices.insert(sourceVertices.end(), sources.begin(), sources.end());
+    }
+    inline const Color & getColor() const {return color;}
+    inline const void * getColorOffset() const {return (const void *)(static_cast<size_t>(vertexBase) * getStride() + getStride() - sizeof(Color));}
+    inline int getFirstIndex() const {return indexOffset;}
+    inline int getFirstVertex() const {return vertexOffset;}
+    inline Format getFormat() const {return format;}
+    inline unsigned int getGeneration() const {return generation;}
+    inline int getIndexCount() const {return indexCount;}
+    inline unsigned int getIndexGeneration() const {return indexGeneration;}
+    inline const void * getIndexOffset(GLsizei indexSize) const {return (const void *)(static_cast<size_t>(indexOffset) * indexSize);}
+    inline unsigned int getLastFrame() const {return lastFrame;}
+    inline const std::vector<RenderedMesh> & getParts() const {return parts;}
+    inline const void * getPositionOffset() const {return (const void *)(static_cast<size_t>(vertexBase) * getStride());}
+    inline GLenum getPositionType() const {return (format == FULL) ? GL_FLOAT : GL_SHORT;}
+    inline GLenum getPrimitive() const {return primitive;}
+    inline const std::vector<GLuint> & getSourceVertices() const {return sourceVertices;}
+    inline GLsizei getStride() const {return getVertexSize(format);}
+    inline int getVertexBase() const {return vertexBase;}
+    inline int getVertexCount() const {return vertexCount;}
+    inline void setFirstIndex(int indexOffset) {this->indexOffset = indexOffset;}
+    inline void setFirstVertex(int vertexBase, int vertexOffset) {this->vertexBase = vertexBase; this->vertexOffset = vertexOffset;}
+    inline void setGeneration(unsigned int generation) {this->generation = generation;}
+    inline void setLastFrame(unsigned int lastFrame) {this->lastFrame = lastFrame;}
 
 private:
 
-    const Mesh *mesh;
+    GLenum primitive;
+    Format format;
+    Color color;
     int indexOffset;
+    int indexCount;
+    int vertexBase;
     int vertexOffset;
+    int vertexCount;
+    unsigned int generation;
+    unsigned int indexGeneration;
+    unsigned int lastFrame;
+    std::vector<RenderedMesh> parts;
+    std::vector<GLuint> sourceVertices;
 
 };
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -3,11 +3,22 @@
 
 #include <GLES2/gl2.h>
 #include <list>
+#include <memory>
 #include <unordered_map>
 #include <glm/glm.hpp>
 
+#include "pinta/bufferarena.h"
+#include "pinta/drawlist.h"
+#include "pinta/drawstate.h"
+#include "pinta/glstate.h"
 #include "pinta/mesh.h"
+#include "pinta/meshbatch.h"
+#include "pinta/meshhandle.h"
+#include "pinta/meshstore.h"
 #include "pinta/renderedmesh.h"
+#include "pinta/scene.h"
+#include "pinta/sdfshape.h"
+#include "pinta/transform2d.h"
 
 namespace pinta {
 
@@ -21,10 +32,48 @@ public:
     void clear();
     void disableStencilTest();
     void draw(const std::list<const Mesh *> &meshes);
+    void draw(const DrawList &drawList);
+    void draw(Scene &scene);
+    void draw(const MeshStore &store, const MeshHandle *handles, size_t count);
+    // Draws every mesh of the batch. The arrays of the batch are uploaded as
+    // they are the first time it is drawn after each tessellation, with the
+    // meshes at their offsets in them.
+    void draw(const MeshBatch &batch);
+    // Draws the shapes with a quad each, blended over what is already drawn
+    void draw(const SdfShape *shapes, size_t count);
     void enableStencilTest(bool enable);
+    // The area given to setDamage, in whole pixels
+    inline BoundingBox getDamage() const {return BoundingBox(glm::vec2(damage[0], damage[1]), glm::vec2(damage[2], damage[3]));}
+    inline unsigned long getDrawCalls() const {return drawCalls;}
+    // The GL calls skipped because they would not have changed anything
+    inline unsigned long getElidedCalls() const {return glState.getElidedCalls();}
+    void popClip();
+    void release(const Mesh *mesh);
+    // Limits the next draws to an area, in the current coordinates, until
+    // the matching popClip. Clips nest, and clear() removes all of them.
+    void pushClip(const BoundingBox &area);
+    // Limits the next draws to the shape of a mesh, which must not change
+    // until the matching popClip
+    void pushClip(const Mesh *mask);
+    void popTransform();
+    // Saves the current transformation, to be restored by popTransform
+    void pushTransform();
+    void release(const MeshStore *store);
+    void release(const MeshBatch *batch);
     void resetTransformations();
+    // Counterclockwise, in radians
+    void rotate(float angle);
     void scale(const glm::vec2& scaleFactor);
     void setBackgroundColor(const glm::vec3 &color);
+    // Limits clear and the draws to an area in window pixels, the only part
+    // of the frame that is drawn again (see DamageTracker). The area is used
+    // until the frame started by the next clear ends, and the frames that are
+    // not given one are drawn whole.
+    void setDamage(const BoundingBox &area);
+    inline void setCompactVertices(bool compact) {compactVertices = compact;}
+    inline void setEvictionAge(unsigned int frames) {evictionAge = frames;}
+    // The time in seconds of the shader animations
+    void setTime(float time);
     void translate(const glm::vec2 &position);
     void updateColor(bool update);
     void updateStencil(bool update);
@@ -33,25 +82,179 @@ private:
 
     static const char *VERTEX_SHADER_TEXT;
     static const char *FRAGMENT_SHADER_TEXT;
+    static const char *SDF_VERTEX_SHADER_TEXT;
+    static const char *SDF_FRAGMENT_SHADER_TEXT;
     static GLuint POS_ATTRIBUTE;
     static GLuint COLOR_ATTRIBUTE;
+    static GLuint CORNER_ATTRIBUTE;
+    static GLuint SHAPE_ATTRIBUTE;
+    static const unsigned int DEFAULT_EVICTION_AGE;
+    static const int RELOCATIONS_PER_FRAME;
+    static const int COMPACTION_CHECKS_PER_FRAME;
+    static const int VERTEX_PAGE_SIZE;
+    static const GLuint CLIP_BITS;
+    static const GLuint MASK_BIT;
+    static const size_t SDF_QUADS_PER_DRAW;
+    static const size_t ITEM_BATCH_VERTICES;
+    static const size_t ITEM_MAX_VERTICES;
+    static const size_t PACKED_MIN_VERTICES;
 
-    void createShaderProgram();
-    void destroyBuffers();
+    // Clips with a mask go through the stencil. The scissor box is the one
+    // in effect inside the clip: min x, min y, max x, max y in pixels.
+    struct Clip {
+        const Mesh *mask;
+        Transform2D transformation;
+        GLint scissor[4];
+    };
+
+    // A mesh to move down in the buffers, by its key in renderedMeshes or by
+    // its store and slot
+    struct CompactionEntry {
+        const Mesh *mesh;
+        const MeshStore *store;
+        uint32_t slot;
+    };
+
+    // The contents of a mesh, wherever they are kept: in a Mesh, a MeshStore
+    // or a MeshBatch
+    struct MeshData {
+        GLenum primitive;
+        const Vertex *vertices;
+        size_t vertexCount;
+        const GLuint *indices;
+        size_t indexCount;
+        unsigned int generation;
+        unsigned int indexGeneration;
+    };
+
+    // The slices of the meshes of a batch, taken from a few slices of the
+    // buffers that hold whole runs of its meshes
+    struct RenderedBatch {
+        unsigned int generation;
+        unsigned int lastFrame;
+        std::vector<RenderedMesh> meshes;
+    };
+
+    struct SdfVertex {
+        GLfloat position[2];
+        GLfloat corner[2];
+        // Half width, half height, corner radius and thickness
+        GLfloat shape[4];
+        uint8_t color[4];
+    };
+
+    // An item of a draw list with its mesh, and the mesh in the buffers
+    // unless the item is transformed on the CPU
+    struct SortedItem {
+        const DrawItem *item;
+        const Mesh *mesh;
+        const RenderedMesh *renderedMesh;
+    };
+
+    void addItemToBatch(const DrawItem &item, const Mesh *mesh);
+    void addToBatch(const RenderedMesh &renderedMesh);
+    void applyScissor();
+    void applyState(const DrawState &state);
+    void applyStencil(GLenum clipOperation = GL_KEEP);
+    void applyTransformation();
+    RenderedMesh::Format chooseFormat(const Vertex *vertices, size_t count) const;
+    void compactBuffers();
+    GLuint createProgram(const char *vertexShaderText, const char *fragmentShaderText);
+    void createSdfProgram();
+    void drawBatch();
+    void drawClipMask(const Clip &clip, GLenum operation);
+    void drawItemBatch();
+    void evictMeshes();
+    RenderedMesh * findCompactionEntry(const CompactionEntry &entry);
+    void freeBuffers(const RenderedMesh &renderedMesh);
+    void freeBuffers(RenderedBatch &renderedBatch);
+    const Mesh * getItemMesh(const DrawItem &item) const;
+    static MeshData getMeshData(const Mesh *mesh);
+    inline const GLint * getScissor() const {return clips.empty() ? damage : clips.back().scissor;}
+    inline int getPageStart(int firstVertex) const {return vertexPageSize ? firstVertex - firstVertex % vertexPageSize : 0;}
+    static bool hasExtension(const char *name);
     GLuint loadShader(GLenum shaderType, const char *shaderSource);
-    void linkProgram();
-    void rebuildVertexBuffers(const std::list<const Mesh *> &meshes);
+    void linkProgram(GLuint program);
+    const void * packIndices(const std::vector<GLuint> &indices);
+    const void * packVertices(const Vertex *vertices, size_t count, RenderedMesh::Format format);
+    RenderedMesh & prepareMesh(const Mesh *mesh);
+    RenderedMesh & prepareMesh(const Mesh *mesh, RenderedMesh &renderedMesh);
+    void rebaseIndices(const RenderedMesh &renderedMesh, int vertexBase, int firstVertex);
+    bool relocateMesh(RenderedMesh &renderedMesh);
+    void splitMesh(const MeshData &mesh, RenderedMesh &renderedMesh);
+    void updateModelview();
+    void updateSdfIndices(size_t quads);
+    void uploadBatch(const MeshBatch &batch, RenderedBatch &renderedBatch);
+    void uploadTransform(GLint location, const Transform2D &transform);
+    void updateMesh(const MeshData &mesh, RenderedMesh &renderedMesh);
+    bool updateSplitMesh(const MeshData &mesh, RenderedMesh &renderedMesh);
 
+    GLState glState;
     GLuint shaderProgram;
-    GLint modelviewUniform;
-    
-    glm::mat4 projectionMatrix;
-    glm::mat4 transformationMatrix;
+    GLint transformUniform;
+    GLint colorUniform;
+    GLint positionScaleUniform;
+    GLint timeUniform;
+    GLint animationUniform;
     std::unordered_map<const Mesh *, RenderedMesh> renderedMeshes;
-    GLuint vertexBuffer;
-    GLuint indexBuffer;
+    std::unordered_map<const MeshStore *, std::vector<RenderedMesh>> storedMeshes;
+    std::unordered_map<const MeshBatch *, RenderedBatch> renderedBatches;
+    GLenum indexType;
+    int vertexPageSize;
+    std::unique_ptr<BufferArena> vertexArenas[RenderedMesh::FORMATS];
+    BufferArena indexArena;
+    // The meshes of the current compaction pass, and the next one to check
+    std::vector<CompactionEntry> compactionEntries;
+    size_t compactionCursor;
+    unsigned int frame;
+    unsigned int evictionAge;
+    std::vector<GLuint> triangleIndices;
+    std::vector<GLushort> shortIndices;
+    std::vector<Vertex> partVertices;
+    std::vector<GLuint> partIndices;
+    std::vector<GLuint> batchIndices;
+    std::vector<int> partVertexMap;
+    std::vector<GLuint> partSources;
+    std::vector<uint8_t> packedVertices;
+    std::vector<SortedItem> sortedItems;
+    // The small meshes of the items of a draw list, transformed and colored
+    // on the CPU to be drawn together, and the item whose transformation,
+    // color and animation are in the uniforms
+    std::vector<Vertex> itemVertices;
+    std::vector<GLuint> itemIndices;
+    GLuint itemVertexBuffer;
+    GLuint itemIndexBuffer;
+    const DrawItem *uniformItem;
+    std::vector<SceneNode *> visibleNodes;
+    DrawList sceneItems;
+    const RenderedMesh *batch;
+    int batchIndexCount;
+    unsigned long drawCalls;
     bool updateStencilEnabled;
     bool stencilTestEnabled;
+    bool updateColorEnabled;
+    bool compactVertices;
+    Transform2D projection;
+    Transform2D transformation;
+    // The projection times the transformation, composed when it is needed
+    Transform2D modelview;
+    bool transformationChanged;
+    std::vector<Transform2D> transformStack;
+    int viewportWidth;
+    int viewportHeight;
+    GLint damage[4];
+    // Whether setDamage was called since the last clear
+    bool damageSet;
+    std::vector<Clip> clips;
+    int stencilClips;
+    std::vector<std::unique_ptr<Mesh>> clipRectangles;
+    // The program and the buffers of the shapes, made on their first draw
+    GLuint sdfProgram;
+    GLint sdfTransformUniform;
+    GLuint sdfVertexBuffer;
+    GLuint sdfIndexBuffer;
+    size_t sdfQuadCapacity;
+    std::vector<SdfVertex> sdfVertices;
 
 };
 
@@ -0,0 +1,75 @@
+#ifndef PINTA_RENDERTHREAD_H
+#define PINTA_RENDERTHREAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "pinta/commandlist.h"
+
+namespace pinta {
+
+// Draws frames on a thread of its own, which owns the GL context and the
+// Renderer, so that the application records frame N + 1 while frame N is
+// drawn and the wait for the vertical sync happens on the render thread.
+// There are two command lists: the application records into getCommands()
+// and hands it over with submit, which waits only if the render thread is
+// still drawing the list that is recorded next. The hand-off is made of two
+// frame counters; a thread only sleeps when it has to wait for the other.
+//
+// The context is taken from the calling thread on construction and given
+// back on destruction, through the makeCurrent function of the display:
+//
+//     RenderThread thread(width, height,
+//         [&](bool current) {display.makeCurrent(current);}, [&]() {display.swap();});
+//
+// A swap function that takes a BoundingBox is given the damage of the frame,
+// as set by CommandList::setDamage, to present it with Display::swap(damage).
+//
+// Errors of the render thread are thrown again by the next submit. The
+// statistics can be read from any thread, also while a frame is drawn.
+class RenderThread {
+
+public:
+
+    RenderThread(int width, int height, std::function<void(bool)> makeCurrent, std::function<void()> swap);
+    RenderThread(int width, int height, std::function<void(bool)> makeCurrent,
+        std::function<void(const BoundingBox &)> swap);
+    RenderThread(const RenderThread &other) = delete;
+    ~RenderThread();
+
+    const RenderThread & operator=(const RenderThread &other) = delete;
+
+    void finish();
+    inline CommandList & getCommands() {return lists[submitted % 2];}
+    inline unsigned long getDrawnFrames() const {return drawn;}
+    void submit();
+
+private:
+
+    void run();
+    void wait(const std::function<bool()> &ready);
+    void wake();
+
+    int width;
+    int height;
+    std::function<void(bool)> makeCurrent;
+    std::function<void(const BoundingBox &)> swap;
+    CommandList lists[2];
+    std::atomic<unsigned long> submitted;
+    std::atomic<unsigned long> drawn;
+    std::atomic<bool> stopping;
+    std::atomic<bool> failed;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::thread thread;
+
+};
+
+}
+
+#endif
@@ -2,24 +2,67 @@
 #define PINTA_SCENE_H
 
 #include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
 
+#include "pinta/boundingbox.h"
 #include "pinta/mesh.h"
+#include "pinta/scenenode.h"
+#include "pinta/spatialgrid.h"
 
 namespace pinta {
 
+// A hierarchy of nodes indexed by their bounds, so that the nodes in an area
+// can be found without going through all of them. Changes to the nodes, and
+// to the vertices of their meshes, are applied to the index by update, which
+// is called by the queries. The meshes drawn by the nodes tell the scene when
+// they change, so that update only looks at those.
 class Scene {
 
 public:
 
-    Scene();
+    Scene(float cellSize = DEFAULT_CELL_SIZE);
     ~Scene();
 
-    inline void addMesh(Mesh *mesh) {meshes.push_back(mesh);}
+    SceneNode * addMesh(Mesh *mesh);
+    SceneNode * createNode(SceneNode *parent = nullptr, const Mesh *mesh = nullptr);
+    void destroyNode(SceneNode *node);
     inline const std::list<Mesh *> & getMeshes() const {return meshes;}
+    inline SceneNode * getRoot() const {return root;}
+    // The node drawn on top at the point, in the order of Renderer::draw
+    SceneNode * pick(const glm::vec2 &point);
+    void query(const BoundingBox &area, std::vector<SceneNode *> &nodes);
+    void update();
 
 private:
 
+    friend class SceneNode;
+
+    // The nodes that draw a mesh, refreshed when its generation changes
+    struct MeshNodes {
+        unsigned int generation;
+        std::vector<SceneNode *> nodes;
+    };
+
+    static const float DEFAULT_CELL_SIZE;
+
+    void destroySubtree(SceneNode *node);
+    void invalidate(SceneNode *node);
+    void refresh(SceneNode *node);
+    void watchChanges(const Mesh *mesh);
+    void watchMesh(SceneNode *node, const Mesh *oldMesh, const Mesh *newMesh);
+
     std::list<Mesh *> meshes;
+    SpatialGrid grid;
+    unsigned int nextId;
+    SceneNode *root;
+    std::vector<SceneNode *> dirtyNodes;
+    std::unordered_map<const Mesh *, MeshNodes> meshNodes;
+    // The meshes changed since the last update, filled by the meshes
+    std::shared_ptr<std::vector<const Mesh *>> changedMeshes;
+    std::vector<SceneNode *> pickedNodes;
 
 };
 
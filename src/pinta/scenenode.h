@@ -0,0 +1,77 @@
+#ifndef PINTA_SCENENODE_H
+#define PINTA_SCENENODE_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "pinta/boundingbox.h"
+#include "pinta/color.h"
+#include "pinta/drawitem.h"
+#include "pinta/drawstate.h"
+#include "pinta/mesh.h"
+
+namespace pinta {
+
+class Scene;
+
+// A node of a scene. The position and scale of a node are relative to its
+// parent, and the world transformation and bounds are refreshed by
+// Scene::update, also when the vertices of its mesh change. Nodes are
+// created and destroyed through their scene.
+class SceneNode {
+
+public:
+
+    inline const std::vector<SceneNode *> & getChildren() const {return children;}
+    inline const Color & getColor() const {return color;}
+    // The item that Renderer::draw(Scene &) draws for the node
+    DrawItem getDrawItem() const;
+    inline unsigned int getId() const {return id;}
+    inline int getLayer() const {return layer;}
+    inline const Mesh * getMesh() const {return mesh;}
+    inline SceneNode * getParent() const {return parent;}
+    inline const glm::vec2 & getPosition() const {return position;}
+    inline const glm::vec2 & getScale() const {return scale;}
+    inline const DrawState & getState() const {return state;}
+    inline const BoundingBox & getWorldBounds() const {return worldBounds;}
+    inline const glm::vec2 & getWorldPosition() const {return worldPosition;}
+    inline const glm::vec2 & getWorldScale() const {return worldScale;}
+    inline void setColor(const Color &color) {this->color = color;}
+    inline void setLayer(int layer) {this->layer = layer;}
+    void setMesh(const Mesh *mesh);
+    void setPosition(const glm::vec2 &position);
+    void setScale(const glm::vec2 &scale);
+    inline void setState(const DrawState &state) {this->state = state;}
+
+private:
+
+    friend class Scene;
+
+    SceneNode(Scene *scene, SceneNode *parent, unsigned int id);
+    SceneNode(const SceneNode &other) = delete;
+    ~SceneNode();
+
+    const SceneNode & operator=(const SceneNode &other) = delete;
+
+    void invalidate();
+
+    Scene *scene;
+    SceneNode *parent;
+    std::vector<SceneNode *> children;
+    unsigned int id;
+    const Mesh *mesh;
+    glm::vec2 position;
+    glm::vec2 scale;
+    Color color;
+    int layer;
+    DrawState state;
+    glm::vec2 worldPosition;
+    glm::vec2 worldScale;
+    BoundingBox worldBounds;
+    bool dirty;
+
+};
+
+}
+
+#endif
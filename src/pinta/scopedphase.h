@@ -0,0 +1,30 @@
+#ifndef PINTA_SCOPEDPHASE_H
+#define PINTA_SCOPEDPHASE_H
+
+#include "pinta/framestats.h"
+#include "pinta/stats.h"
+
+namespace pinta {
+
+// Adds the time from its construction to its destruction to a phase of the
+// current frame. Used through PINTA_PHASE, which is empty without PINTA_STATS.
+class ScopedPhase {
+
+public:
+
+    inline ScopedPhase(FrameStats::Phase phase): phase(phase), start(Stats::now()) {}
+    ScopedPhase(const ScopedPhase &other) = delete;
+    inline ~ScopedPhase() {stats().addPhase(phase, start, Stats::now());}
+
+    const ScopedPhase & operator=(const ScopedPhase &other) = delete;
+
+private:
+
+    FrameStats::Phase phase;
+    uint64_t start;
+
+};
+
+}
+
+#endif
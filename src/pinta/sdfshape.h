@@ -0,0 +1,38 @@
+#ifndef PINTA_SDFSHAPE_H
+#define PINTA_SDFSHAPE_H
+
+#include <glm/glm.hpp>
+
+#include "pinta/color.h"
+
+namespace pinta {
+
+// A circle, a rectangle with rounded corners or the outline of one, drawn
+// by Renderer as a single quad whose pixels are covered from their distance
+// to the edge, so it has smooth edges and the same cost at any size. A
+// circle is a square with its half size as the corner radius. With a
+// thickness the shape is only a band of that width inside its edge.
+class SdfShape {
+
+public:
+
+    SdfShape(const glm::vec2 &position, float width, float height, float cornerRadius, float thickness, const Color &color);
+
+    static SdfShape circle(const glm::vec2 &position, float radius, const Color &color = Color(0, 0, 0));
+    static SdfShape rectangle(const glm::vec2 &position, float w, float h, float cornerRadius = 0,
+        const Color &color = Color(0, 0, 0));
+    static SdfShape ring(const glm::vec2 &position, float radius, float thickness, const Color &color = Color(0, 0, 0));
+
+    // The center of the shape
+    glm::vec2 position;
+    float width;
+    float height;
+    float cornerRadius;
+    float thickness;
+    Color color;
+
+};
+
+}
+
+#endif
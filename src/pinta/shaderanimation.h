@@ -0,0 +1,56 @@
+#ifndef PINTA_SHADERANIMATION_H
+#define PINTA_SHADERANIMATION_H
+
+#include <glm/glm.hpp>
+
+#include "pinta/animationengine.h"
+#include "pinta/color.h"
+
+namespace pinta {
+
+// An animation evaluated by the vertex shader from the time given to
+// Renderer::setTime, so that animated items cost nothing per frame on the
+// CPU and no uploads. It moves, scales and tints the items that use it from
+// a start keyframe to an end keyframe, once, in a loop, or back and forth.
+// The offset is in the coordinates of the item, before its own position and
+// scale, and the color multiplies its color. Culling does not know about the
+// animation.
+class ShaderAnimation {
+
+public:
+
+    enum Repeat {
+        ONCE,
+        LOOP,
+        ALTERNATE
+    };
+
+    // The values packed into the uniforms of the shader
+    static const int UNIFORMS = 7;
+
+    ShaderAnimation(float duration = 0, AnimationEngine::Easing easing = AnimationEngine::LINEAR, Repeat repeat = LOOP,
+        float startTime = 0);
+
+    inline float getDuration() const {return duration;}
+    inline AnimationEngine::Easing getEasing() const {return easing;}
+    inline Repeat getRepeat() const {return repeat;}
+    inline float getStartTime() const {return uniforms[0].x;}
+    inline const glm::vec4 * getUniforms() const {return uniforms;}
+    void setAlpha(float startAlpha, float endAlpha);
+    void setColor(const Color &startColor, const Color &endColor);
+    void setOffset(const glm::vec2 &startOffset, const glm::vec2 &endOffset);
+    void setScale(const glm::vec2 &startScale, const glm::vec2 &endScale);
+    inline void setStartTime(float startTime) {uniforms[0].x = startTime;}
+
+private:
+
+    float duration;
+    AnimationEngine::Easing easing;
+    Repeat repeat;
+    glm::vec4 uniforms[UNIFORMS];
+
+};
+
+}
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef PINTA_SHAPEDESCRIPTION_H
+#define PINTA_SHAPEDESCRIPTION_H
+
+#include "pinta/color.h"
+
+namespace pinta {
+
+// The parameters of a shape to tessellate in a batch, see tessellate. A
+// circle has the radius as its corner radius and the diameter as its size.
+class ShapeDescription {
+
+public:
+
+    enum Type {
+        RECTANGLE,
+        CIRCLE
+    };
+
+    ShapeDescription(Type type, float width, float height, float cornerRadius, int segments, const Color &color);
+
+    static ShapeDescription circle(float radius, const Color &color = Color(0, 0, 0), int segments = 32);
+    static ShapeDescription rectangle(float w, float h, float cornerRadius = 0, const Color &color = Color(0, 0, 0),
+        int segments = 16);
+
+    Type type;
+    float width;
+    float height;
+    float cornerRadius;
+    int segments;
+    Color color;
+
+};
+
+}
+
+#endif
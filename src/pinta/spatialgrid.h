@@ -0,0 +1,57 @@
+#ifndef PINTA_SPATIALGRID_H
+#define PINTA_SPATIALGRID_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "pinta/boundingbox.h"
+
+namespace pinta {
+
+class SceneNode;
+
+// A uniform grid over the plane that indexes the nodes of a scene by their
+// world bounds. Only the cells that hold nodes are stored. Nodes that would
+// take too many cells are kept in a separate list checked by every query.
+class SpatialGrid {
+
+public:
+
+    SpatialGrid(float cellSize);
+
+    void insert(SceneNode *node, const BoundingBox &bounds);
+    void move(SceneNode *node, const BoundingBox &oldBounds, const BoundingBox &newBounds);
+    void query(const BoundingBox &area, std::vector<SceneNode *> &nodes) const;
+    void remove(SceneNode *node, const BoundingBox &bounds);
+
+private:
+
+    struct CellRange {
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+        bool oversized;
+
+        inline bool operator==(const CellRange &other) const {
+            return oversized == other.oversized && minX == other.minX && minY == other.minY && maxX == other.maxX
+                && maxY == other.maxY;
+        }
+    };
+
+    static const float MAX_NODE_CELLS;
+
+    static inline uint64_t getKey(int x, int y) {return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);}
+
+    CellRange getCells(const BoundingBox &bounds, float maxCells) const;
+
+    float cellSize;
+    std::unordered_map<uint64_t, std::vector<SceneNode *>> cells;
+    std::vector<SceneNode *> oversizedNodes;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef PINTA_STATS_H
+#define PINTA_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "pinta/framestats.h"
+#include "pinta/statsconfig.h"
+
+namespace pinta {
+
+// Statistics of the frames drawn by the library. Frames end when the renderer
+// is cleared. The library only collects them when built with PINTA_STATS
+// (the default, see --disable-stats), otherwise every count stays at zero and
+// the instrumentation costs nothing.
+//
+// Any thread can add to the current frame, and the results can be read from
+// any thread as copies.
+//
+// A timeline of the phases of each frame can also be written in the Chrome
+// trace event format, to be opened in chrome://tracing or Perfetto.
+class Stats {
+
+public:
+
+    static const int FRAME_TIME_BUCKETS;
+
+    Stats();
+    ~Stats();
+
+    inline void add(FrameStats::Counter counter, uint64_t amount = 1) {
+        counters[counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+    void addFrameTime(uint64_t nanoseconds);
+    void addPhase(FrameStats::Phase phase, uint64_t start, uint64_t end);
+    void endFrame();
+    unsigned long getFrames() const;
+    // Frames counted by their time in milliseconds, the last bucket counts
+    // the longer frames
+    std::vector<uint64_t> getFrameTimeHistogram() const;
+    FrameStats getLastFrame() const;
+    FrameStats getTotal() const;
+    static bool isEnabled();
+    bool isTracing() const;
+    static uint64_t now();
+    void reset();
+    void startTrace(const std::string &path);
+    void stopTrace();
+
+private:
+
+    struct TraceEvent {
+        FrameStats::Phase phase;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    void writeTrace();
+
+    // The current frame, added to without the lock
+    std::atomic<uint64_t> counters[FrameStats::COUNTERS];
+    std::atomic<uint64_t> phaseTimes[FrameStats::PHASES];
+    // Whether a trace is open, so that the phases take the lock only then
+    std::atomic<bool> tracing;
+    // The rest is only used with the lock
+    mutable std::mutex mutex;
+    FrameStats lastFrame;
+    FrameStats total;
+    unsigned long frames;
+    std::vector<uint64_t> frameTimeHistogram;
+    std::ofstream trace;
+    std::vector<TraceEvent> traceEvents;
+    uint64_t frameStart;
+    bool firstTraceEvent;
+
+};
+
+Stats & stats();
+
+}
+
+#ifdef PINTA_STATS
+#define PINTA_COUNT(counter, amount) pinta::stats().add(pinta::FrameStats::counter, amount)
+#define PINTA_END_FRAME() pinta::stats().endFrame()
+#define PINTA_FRAME_TIME(nanoseconds) pinta::stats().addFrameTime(nanoseconds)
+#define PINTA_PHASE(phase) pinta::ScopedPhase scopedPhase(pinta::FrameStats::phase)
+#else
+#define PINTA_COUNT(counter, amount)
+#define PINTA_END_FRAME()
+#define PINTA_FRAME_TIME(nanoseconds)
+#define PINTA_PHASE(phase)
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef PINTA_STROKESTYLE_H
+#define PINTA_STROKESTYLE_H
+
+namespace pinta {
+
+// How a PathTessellator strokes the contours of a path. The miter limit is
+// the longest miter join, as a multiple of the width, drawn before it falls
+// back to a bevel join.
+class StrokeStyle {
+
+public:
+
+    enum Join {
+        MITER_JOIN,
+        ROUND_JOIN,
+        BEVEL_JOIN
+    };
+
+    enum Cap {
+        BUTT_CAP,
+        ROUND_CAP,
+        SQUARE_CAP
+    };
+
+    StrokeStyle(float width = 1.0, Join join = MITER_JOIN, Cap cap = BUTT_CAP, float miterLimit = 4.0);
+
+    float width;
+    Join join;
+    Cap cap;
+    float miterLimit;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef PINTA_TESSELLATIONCACHE_H
+#define PINTA_TESSELLATIONCACHE_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "pinta/mesh.h"
+#include "pinta/tessellationkey.h"
+
+namespace pinta {
+
+// Keeps the meshes generated for a set of shape parameters, so that they can
+// be reused instead of generated again. Meshes are immutable once inserted.
+// When the memory used goes over the budget, the least recently used meshes
+// are dropped. The cache can be used from several threads, such as those
+// that tessellate shapes with sharedRectangle and sharedCircle.
+class TessellationCache {
+
+public:
+
+    TessellationCache(size_t budget = DEFAULT_BUDGET);
+
+    void clear();
+    std::shared_ptr<const Mesh> find(const TessellationKey &key);
+    size_t getBudget() const;
+    unsigned long getHits() const;
+    unsigned long getMisses() const;
+    size_t getSize() const;
+    std::shared_ptr<const Mesh> insert(const TessellationKey &key, Mesh *mesh);
+    void setBudget(size_t budget);
+
+private:
+
+    struct KeyHash {
+        inline size_t operator()(const TessellationKey &key) const {return key.getHash();}
+    };
+
+    typedef std::list<std::pair<TessellationKey, std::shared_ptr<const Mesh>>> Entries;
+
+    static const size_t DEFAULT_BUDGET;
+
+    static size_t getMeshSize(const Mesh &mesh);
+
+    void trim();
+
+    mutable std::mutex mutex;
+    size_t budget;
+    size_t size;
+    unsigned long hits;
+    unsigned long misses;
+    Entries entries;
+    std::unordered_map<TessellationKey, Entries::iterator, KeyHash> index;
+
+};
+
+}
+
+#endif
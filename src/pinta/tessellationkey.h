@@ -0,0 +1,35 @@
+#ifndef PINTA_TESSELLATIONKEY_H
+#define PINTA_TESSELLATIONKEY_H
+
+#include <cstddef>
+
+namespace pinta {
+
+class TessellationKey {
+
+public:
+
+    enum Shape {
+        CIRCLE,
+        RECTANGLE
+    };
+
+    TessellationKey(Shape shape, float w, float h, float cornerRadius, int segments);
+
+    bool operator==(const TessellationKey &other) const;
+
+    size_t getHash() const;
+
+private:
+
+    Shape shape;
+    float w;
+    float h;
+    float cornerRadius;
+    int segments;
+
+};
+
+}
+
+#endif
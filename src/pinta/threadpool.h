@@ -0,0 +1,68 @@
+#ifndef PINTA_THREADPOOL_H
+#define PINTA_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pinta {
+
+// Runs a task over a range of indices on several threads, the calling one
+// included. Each thread starts with an equal part of the range and takes
+// small chunks from its front; a thread that runs out steals half of what is
+// left to another one. Tasks must not call run themselves.
+class ThreadPool {
+
+public:
+
+    ThreadPool(unsigned int threads = std::thread::hardware_concurrency());
+    ThreadPool(const ThreadPool &other) = delete;
+    ~ThreadPool();
+
+    const ThreadPool & operator=(const ThreadPool &other) = delete;
+
+    inline unsigned int getThreads() const {return threads;}
+    void run(size_t count, const std::function<void(size_t)> &task);
+
+private:
+
+    struct Queue {
+        std::mutex mutex;
+        size_t begin;
+        size_t end;
+    };
+
+    static const size_t CHUNK_SIZE;
+
+    bool steal(unsigned int queue);
+    bool take(unsigned int queue, size_t &begin, size_t &end);
+    void wait(unsigned int queue);
+    void work(unsigned int queue);
+
+    unsigned int threads;
+    std::unique_ptr<Queue[]> queues;
+    std::vector<std::thread> workers;
+    const std::function<void(size_t)> *task;
+    std::atomic<size_t> remaining;
+    std::exception_ptr error;
+    unsigned long job;
+    bool stopping;
+    std::mutex mutex;
+    std::condition_variable jobCondition;
+    std::condition_variable doneCondition;
+    std::mutex runMutex;
+
+};
+
+// The pool shared by the library, with a thread per core
+ThreadPool & threadPool();
+
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef PINTA_TRANSFORM2D_H
+#define PINTA_TRANSFORM2D_H
+
+#include <glm/glm.hpp>
+
+namespace pinta {
+
+// A 2D affine transformation: the first two rows of a 3x3 matrix. Translate,
+// scale and rotate apply before the current transformation, in the local
+// coordinates, like the operations of the renderer.
+class Transform2D {
+
+public:
+
+    Transform2D();
+    Transform2D(float xx, float xy, float x, float yx, float yy, float y);
+
+    Transform2D operator*(const Transform2D &other) const;
+    bool operator==(const Transform2D &other) const;
+    inline bool operator!=(const Transform2D &other) const {return !(*this == other);}
+
+    glm::vec2 apply(const glm::vec2 &point) const;
+    inline float get(int row, int column) const {return m[row][column];}
+    // The lengths of the transformed x and y axes
+    glm::vec2 getScale() const;
+    Transform2D inverse() const;
+    void rotate(float angle);
+    void scale(const glm::vec2 &scaleFactor);
+    void translate(const glm::vec2 &position);
+
+private:
+
+    float m[2][3];
+
+};
+
+}
+
+#endif
@@ -2,20 +2,29 @@
 
 namespace pinta {
 
+const float RenderedMesh::POSITION_SCALE = 4.0;
+
 RenderedMesh::RenderedMesh():
-    mesh(nullptr), vertexOffset(0), indexOffset(0)
+    primitive(GL_TRIANGLES), format(FULL), color(0, 0, 0), indexOffset(0), indexCount(0), vertexBase(0),
+    vertexOffset(0), vertexCount(0), generation(0), indexGeneration(0), lastFrame(0)
 {
 
 }
 
-RenderedMesh::RenderedMesh(const Mesh *mesh, int vertexOffset, int indexOffset):
-    mesh(mesh), vertexOffset(vertexOffset), indexOffset(indexOffset)
+RenderedMesh::RenderedMesh(unsigned int generation, unsigned int indexGeneration, GLenum primitive, Format format,
+        const Color &color, int vertexBase, int vertexOffset, int vertexCount, int indexOffset, int indexCount):
+    primitive(primitive), format(format), color(color), indexOffset(indexOffset), indexCount(indexCount),
+    vertexBase(vertexBase), vertexOffset(vertexOffset), vertexCount(vertexCount), generation(generation),
+    indexGeneration(indexGeneration), lastFrame(0)
 {
 
 }
 
 RenderedMesh::RenderedMesh(const RenderedMesh &other):
-    mesh(other.mesh), vertexOffset(other.vertexOffset), indexOffset(other.indexOffset)
+    primitive(other.primitive), format(other.format), color(other.color), indexOffset(other.indexOffset),
+    indexCount(other.indexCount), vertexBase(other.vertexBase), vertexOffset(other.vertexOffset), vertexCount(other.vertexCount),
+    generation(other.generation), indexGeneration(other.indexGeneration), lastFrame(other.lastFrame), parts(other.parts),
+    sourceVertices(other.sourceVertices)
 {
 
 }
@@ -25,4 +34,36 @@ RenderedMesh::~RenderedMesh()
 
 }
 
-}
\ No newline at end of file
+GLsizei RenderedMesh::getVertexSize(Format format)
+{
+    switch (format) {
+        case PACKED_COLOR:
+            return sizeof(GLshort) * 2 + sizeof(Color);
+        case PACKED:
+            return sizeof(GLshort) * 2;
+        default:
+            return sizeof(Vertex);
+    }
+}
+
+const RenderedMesh & RenderedMesh::operator=(const RenderedMesh &other)
+{
+    if (this == &other)
+        return *this;
+    primitive = other.primitive;
+    format = other.format;
+    color = other.color;
+    indexOffset = other.indexOffset;
+    indexCount = other.indexCount;
+    vertexBase = other.vertexBase;
+    vertexOffset = other.vertexOffset;
+    vertexCount = other.vertexCount;
+    generation = other.generation;
+    indexGeneration = other.indexGeneration;
+    lastFrame = other.lastFrame;
+    parts = other.parts;
+    sourceVertices = other.sourceVertices;
+    return *this;
+}
+
+}
@@ -1,25 +1,42 @@
 #include "pinta/renderer.h"
+#include "pinta/extensions.h"
 #include "pinta/renderererror.h"
 #include "pinta/renderedmesh.h"
+#include "pinta/scopedphase.h"
 
-#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 
 namespace pinta {
 
 const char *Renderer::VERTEX_SHADER_TEXT = R"(
-    uniform mat4 u_modelview;
-    attribute vec4 a_position;
+    uniform vec4 u_transform[2];
+    uniform vec4 u_color;
+    uniform float u_positionScale;
+    uniform float u_time;
+    uniform vec4 u_animation[7];
+    attribute vec2 a_position;
     attribute vec4 a_color;
     varying vec4 v_color;
     void main()
     {
-        v_color = a_color;
-        gl_Position = u_modelview * a_position;
+        // The repeat modes are selected by weights, and the easing is a cubic
+        float t = max((u_time - u_animation[0].x) * u_animation[0].y, 0.0);
+        t = dot(u_animation[1].xyz, vec3(min(t, 1.0), fract(t), 1.0 - abs(mod(t, 2.0) - 1.0)));
+        float e = ((u_animation[2].x * t + u_animation[2].y) * t + u_animation[2].z) * t;
+        vec2 offset = mix(u_animation[3].xy, u_animation[3].zw, e);
+        vec2 scale = mix(u_animation[4].xy, u_animation[4].zw, e);
+        v_color = a_color * u_color * mix(u_animation[5], u_animation[6], e);
+        vec3 position = vec3(a_position * u_positionScale * scale + offset, 1.0);
+        gl_Position = vec4(dot(u_transform[0].xyz, position), dot(u_transform[1].xyz, position), 0.0, 1.0);
     }
 )";
 
 const char *Renderer::FRAGMENT_SHADER_TEXT = R"(
-    //precision mediump float;
+    #ifdef GL_ES
+    precision mediump float;
+    #endif
     varying vec4 v_color;
     void main()
     {
@@ -27,78 +44,503 @@ const char *Renderer::FRAGMENT_SHADER_TEXT = R"(
     }
 )";
 
+const char *Renderer::SDF_VERTEX_SHADER_TEXT = R"(
+    uniform vec4 u_transform[2];
+    uniform vec2 u_pixelSize;
+    attribute vec2 a_position;
+    attribute vec4 a_color;
+    attribute vec2 a_corner;
+    attribute vec4 a_shape;
+    varying vec2 v_local;
+    varying vec4 v_shape;
+    varying vec4 v_color;
+    varying float v_pixel;
+    void main()
+    {
+        // The size of a pixel in the coordinates of the shape, and a quad a
+        // pixel larger than the shape for its smooth edge
+        v_pixel = max(u_pixelSize.x / length(vec2(u_transform[0].x, u_transform[1].x)),
+            u_pixelSize.y / length(vec2(u_transform[0].y, u_transform[1].y)));
+        v_local = a_corner * (a_shape.xy + v_pixel);
+        v_shape = a_shape;
+        v_color = a_color;
+        vec3 position = vec3(a_position + v_local, 1.0);
+        gl_Position = vec4(dot(u_transform[0].xyz, position), dot(u_transform[1].xyz, position), 0.0, 1.0);
+    }
+)";
+
+const char *Renderer::SDF_FRAGMENT_SHADER_TEXT = R"(
+    #ifdef GL_OES_standard_derivatives
+    #extension GL_OES_standard_derivatives : enable
+    #endif
+    #ifdef GL_ES
+    precision mediump float;
+    #endif
+    varying vec2 v_local;
+    varying vec4 v_shape;
+    varying vec4 v_color;
+    varying float v_pixel;
+    void main()
+    {
+        // The distance to a rounded rectangle of half size v_shape.xy and
+        // corner radius v_shape.z, or to a band of width v_shape.w inside it
+        vec2 q = abs(v_local) - v_shape.xy + v_shape.z;
+        float d = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - v_shape.z;
+        if (v_shape.w > 0.0) {
+            d = abs(d + v_shape.w * 0.5) - v_shape.w * 0.5;
+        }
+        // Without derivatives the size of a pixel comes from the transformation
+        #ifdef GL_OES_standard_derivatives
+        float pixel = fwidth(d);
+        #else
+        float pixel = v_pixel;
+        #endif
+        float coverage = clamp(0.5 - d / pixel, 0.0, 1.0);
+        if (coverage <= 0.0) {
+            discard;
+        }
+        gl_FragColor = vec4(v_color.rgb, v_color.a * coverage);
+    }
+)";
+
 GLuint Renderer::POS_ATTRIBUTE = 0;
 GLuint Renderer::COLOR_ATTRIBUTE = 1;
+GLuint Renderer::CORNER_ATTRIBUTE = 2;
+GLuint Renderer::SHAPE_ATTRIBUTE = 3;
+const unsigned int Renderer::DEFAULT_EVICTION_AGE = 300;
+const int Renderer::RELOCATIONS_PER_FRAME = 16;
+const int Renderer::COMPACTION_CHECKS_PER_FRAME = 256;
+const int Renderer::VERTEX_PAGE_SIZE = 65536;
+// The low bits of the stencil count the clips that contain each pixel, and
+// the high bit is the mask written by updateStencil
+const GLuint Renderer::CLIP_BITS = 0x7f;
+const GLuint Renderer::MASK_BIT = 0x80;
+// The most quads that 16 bit indices can reach
+const size_t Renderer::SDF_QUADS_PER_DRAW = 16384;
+// The most vertices that 16 bit indices can reach, and the largest meshes
+// that are cheaper to transform on the CPU than to draw on their own
+const size_t Renderer::ITEM_BATCH_VERTICES = 65536;
+const size_t Renderer::ITEM_MAX_VERTICES = 64;
+const size_t Renderer::PACKED_MIN_VERTICES = 4096;
+
+static const ShaderAnimation NO_ANIMATION;
+
+static bool isBatchable(GLenum primitive);
+static int getPrimitiveSize(GLenum primitive);
+static GLenum triangulate(GLenum primitive, const GLuint *indices, size_t count, int base, std::vector<GLuint> &triangles);
 
 Renderer::Renderer(int viewportWidth, int viewportHeight):
-    updateStencilEnabled(false), stencilTestEnabled(false)
+    indexType(hasExtension("GL_OES_element_index_uint") ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT),
+    vertexPageSize(indexType == GL_UNSIGNED_INT ? 0 : VERTEX_PAGE_SIZE),
+    indexArena(glState, GL_ELEMENT_ARRAY_BUFFER, indexType == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort)),
+    compactionCursor(0), frame(0), evictionAge(DEFAULT_EVICTION_AGE), itemVertexBuffer(0), itemIndexBuffer(0),
+    uniformItem(nullptr), batch(nullptr), batchIndexCount(0), drawCalls(0), updateStencilEnabled(false),
+    stencilTestEnabled(false), updateColorEnabled(true), compactVertices(false),
+    projection(2.0 / viewportWidth, 0.0, 0.0, 0.0, 2.0 / viewportHeight, 0.0), transformationChanged(true),
+    viewportWidth(viewportWidth), viewportHeight(viewportHeight), damage{0, 0, viewportWidth, viewportHeight},
+    damageSet(false), stencilClips(0),
+    sdfProgram(0), sdfVertexBuffer(0), sdfIndexBuffer(0), sdfQuadCapacity(0)
 {
-    createShaderProgram();
-    linkProgram();
-    glUseProgram(shaderProgram);
+    for (int format = 0; format < RenderedMesh::FORMATS; format++) {
+        vertexArenas[format].reset(new BufferArena(glState, GL_ARRAY_BUFFER,
+            RenderedMesh::getVertexSize(static_cast<RenderedMesh::Format>(format)), 1024, vertexPageSize));
+    }
+    shaderProgram = createProgram(VERTEX_SHADER_TEXT, FRAGMENT_SHADER_TEXT);
+    glState.useProgram(shaderProgram);
+    glState.vertexAttribArray(POS_ATTRIBUTE, true);
+    glState.vertexAttribArray(COLOR_ATTRIBUTE, true);
     glViewport(0, 0, viewportWidth, viewportHeight);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glClearColor(0.0, 0.0, 0.0, 1.0);
     glClearStencil(0);
-    glStencilFunc(GL_EQUAL, 1, 1);
-    modelviewUniform = glGetUniformLocation(shaderProgram, "u_modelview");
-    projectionMatrix = glm::ortho(-viewportWidth/2.0, viewportWidth/2.0, -viewportHeight/2.0, viewportHeight/2.0, -1.0, 1.0);
+    applyStencil();
+    transformUniform = glGetUniformLocation(shaderProgram, "u_transform");
+    colorUniform = glGetUniformLocation(shaderProgram, "u_color");
+    positionScaleUniform = glGetUniformLocation(shaderProgram, "u_positionScale");
+    timeUniform = glGetUniformLocation(shaderProgram, "u_time");
+    animationUniform = glGetUniformLocation(shaderProgram, "u_animation");
 }
 
 Renderer::~Renderer()
 {
-    destroyBuffers();
+    if (sdfProgram) {
+        glState.deleteBuffer(sdfVertexBuffer);
+        glState.deleteBuffer(sdfIndexBuffer);
+    }
+    if (itemVertexBuffer) {
+        glState.deleteBuffer(itemVertexBuffer);
+        glState.deleteBuffer(itemIndexBuffer);
+    }
 }
 
 void Renderer::clear()
 {
+    // Clearing the screen starts a new frame
+    PINTA_END_FRAME();
+    frame++;
+    evictMeshes();
+    compactBuffers();
+    if (!damageSet) {
+        setDamage(BoundingBox(glm::vec2(0.0, 0.0), glm::vec2(viewportWidth, viewportHeight)));
+    }
+    damageSet = false;
+    clips.clear();
+    stencilClips = 0;
+    applyScissor();
+    glState.stencilWriteMask(CLIP_BITS | MASK_BIT);
     glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    applyStencil();
 }
 
 void Renderer::disableStencilTest()
 {
-    glDisable(GL_STENCIL_TEST);
+    stencilTestEnabled = false;
+    updateStencilEnabled = false;
+    applyStencil();
 }
 
 void Renderer::draw(const std::list<const Mesh *> &meshes)
 {
+    applyTransformation();
     for (const Mesh *mesh: meshes) {
-        if (renderedMeshes.count(mesh) == 0) {
-            rebuildVertexBuffers(meshes);
-            break;
+        addToBatch(prepareMesh(mesh));
+    }
+    drawBatch();
+}
+
+void Renderer::draw(const DrawList &drawList)
+{
+    // Sort the items inside each layer by state, transformation and position
+    // in the index buffer, so that state changes are minimized and the most
+    // meshes are batched together. The small meshes without an animation are
+    // transformed on the CPU instead, so that the items of a state are drawn
+    // together whatever their transformation and color.
+    sortedItems.clear();
+    updateModelview();
+    for (const DrawItem &item: drawList.getItems()) {
+        const Mesh *mesh = getItemMesh(item);
+        GLenum primitive = mesh->getPrimitive();
+        bool transformed = !item.animation && mesh->getVertices().size() <= ITEM_MAX_VERTICES
+            && (primitive == GL_TRIANGLES || primitive == GL_TRIANGLE_STRIP || primitive == GL_TRIANGLE_FAN);
+        sortedItems.push_back({&item, mesh, transformed ? nullptr : &prepareMesh(mesh)});
+    }
+    std::sort(sortedItems.begin(), sortedItems.end(), [](const SortedItem &a, const SortedItem &b) {
+        if (a.item->isDrawnBefore(*b.item)) {
+            return true;
+        } else if (b.item->isDrawnBefore(*a.item)) {
+            return false;
+        } else {
+            return (a.renderedMesh ? a.renderedMesh->getFirstIndex() : -1) < (b.renderedMesh ? b.renderedMesh->getFirstIndex() : -1);
+        }
+    });
+
+    glState.useProgram(shaderProgram);
+    DrawState previousState(stencilTestEnabled, updateStencilEnabled, updateColorEnabled);
+    const DrawItem *previousItem = nullptr;
+    uniformItem = nullptr;
+    for (const SortedItem &sortedItem: sortedItems) {
+        const DrawItem &item = *sortedItem.item;
+        bool stateChanged = !previousItem || item.state != previousItem->state;
+        if (stateChanged || item.layer != previousItem->layer) {
+            drawItemBatch();
         }
+        if (stateChanged) {
+            applyState(item.state);
+        }
+        previousItem = &item;
+        if (!sortedItem.renderedMesh) {
+            addItemToBatch(item, sortedItem.mesh);
+            continue;
+        }
+
+        bool transformationChanged = !uniformItem || item.position != uniformItem->position || item.scale != uniformItem->scale;
+        bool colorChanged = !uniformItem || item.color != uniformItem->color;
+        bool animationChanged = !uniformItem || item.animation != uniformItem->animation;
+        if (transformationChanged || colorChanged || animationChanged) {
+            drawBatch();
+        }
+        if (transformationChanged) {
+            Transform2D itemTransform = modelview;
+            itemTransform.translate(item.position);
+            itemTransform.scale(item.scale);
+            uploadTransform(transformUniform, itemTransform);
+        }
+        if (colorChanged) {
+            glState.uniform(colorUniform, item.color.getRed() / 255.0, item.color.getGreen() / 255.0,
+                item.color.getBlue() / 255.0, item.color.getAlpha() / 255.0);
+        }
+        if (animationChanged) {
+            const ShaderAnimation &animation = item.animation ? *item.animation : NO_ANIMATION;
+            glState.uniformVectors(animationUniform, ShaderAnimation::UNIFORMS, &animation.getUniforms()[0].x);
+        }
+        addToBatch(*sortedItem.renderedMesh);
+        uniformItem = &item;
     }
+    drawItemBatch();
 
-    for (const Mesh *mesh: meshes) {
-        const RenderedMesh &renderedMesh = renderedMeshes[mesh];
-        glVertexAttribPointer(POS_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, renderedMesh.getStride(), renderedMesh.getPositionOffset());
-        glVertexAttribPointer(COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, renderedMesh.getStride(), renderedMesh.getColorOffset());
-        glDrawElements(mesh->getPrimitive(), mesh->getIndexCount(), GL_UNSIGNED_SHORT, renderedMesh.getIndexOffset());
+    // Leave the state as it was set through the immediate calls. The
+    // uniforms are set again by the next immediate draw.
+    if (previousItem) {
+        applyState(previousState);
     }
 }
 
+void Renderer::draw(Scene &scene)
+{
+    // Only the nodes inside the viewport are drawn. The viewport is mapped
+    // back to scene coordinates through the current transformation.
+    updateModelview();
+    Transform2D inverse = modelview.inverse();
+    BoundingBox area;
+    for (const glm::vec2 &corner: {glm::vec2(-1.0, -1.0), glm::vec2(1.0, -1.0), glm::vec2(-1.0, 1.0), glm::vec2(1.0, 1.0)}) {
+        area.merge(inverse.apply(corner));
+    }
+
+    scene.query(area, visibleNodes);
+    sceneItems.clear();
+    for (const SceneNode *node: visibleNodes) {
+        sceneItems.add(node->getMesh(), node->getWorldPosition(), node->getWorldScale(), node->getState(), node->getLayer(),
+            node->getColor());
+    }
+    draw(sceneItems);
+}
+
+void Renderer::draw(const MeshStore &store, const MeshHandle *handles, size_t count)
+{
+    // The meshes of a store are found by the index of their slot, and the
+    // handles of destroyed meshes are skipped
+    applyTransformation();
+    std::vector<RenderedMesh> &renderedStore = storedMeshes[&store];
+    if (renderedStore.size() < store.getCapacity()) {
+        renderedStore.resize(store.getCapacity());
+    }
+    for (size_t i = 0; i < count; i++) {
+        MeshHandle handle = handles[i];
+        if (!store.isValid(handle)) {
+            continue;
+        }
+        RenderedMesh &renderedMesh = renderedStore[handle.index];
+        if (renderedMesh.getGeneration() != store.getGeneration(handle)) {
+            PINTA_PHASE(UPLOAD);
+            MeshData mesh = {store.getPrimitive(handle), store.getVertices(handle), store.getVertexCount(handle),
+                store.getIndices(handle), store.getIndexCount(handle), store.getGeneration(handle),
+                store.getIndexGeneration(handle)};
+            updateMesh(mesh, renderedMesh);
+        }
+        renderedMesh.setLastFrame(frame);
+        addToBatch(renderedMesh);
+    }
+    drawBatch();
+}
+
+void Renderer::draw(const MeshBatch &batch)
+{
+    applyTransformation();
+    RenderedBatch &renderedBatch = renderedBatches[&batch];
+    if (renderedBatch.generation != batch.getGeneration()) {
+        PINTA_PHASE(UPLOAD);
+        uploadBatch(batch, renderedBatch);
+    }
+    renderedBatch.lastFrame = frame;
+    for (const RenderedMesh &renderedMesh: renderedBatch.meshes) {
+        addToBatch(renderedMesh);
+    }
+    drawBatch();
+}
+
+void Renderer::draw(const SdfShape *shapes, size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    if (!sdfProgram) {
+        createSdfProgram();
+    }
+
+    // Four vertices per shape, with the corner of the quad they are at
+    PINTA_PHASE(SUBMIT);
+    sdfVertices.resize(count * 4);
+    SdfVertex *vertex = sdfVertices.data();
+    for (size_t i = 0; i < count; i++) {
+        const SdfShape &shape = shapes[i];
+        float halfWidth = std::abs(shape.width) / 2;
+        float halfHeight = std::abs(shape.height) / 2;
+        for (const glm::vec2 &corner: {glm::vec2(-1.0, -1.0), glm::vec2(1.0, -1.0), glm::vec2(1.0, 1.0), glm::vec2(-1.0, 1.0)}) {
+            *vertex = {{shape.position.x, shape.position.y}, {corner.x, corner.y},
+                {halfWidth, halfHeight, std::min(std::max(shape.cornerRadius, 0.0f), std::min(halfWidth, halfHeight)), shape.thickness},
+                {shape.color.getRed(), shape.color.getGreen(), shape.color.getBlue(), shape.color.getAlpha()}};
+            vertex++;
+        }
+    }
+    // A draw takes at most SDF_QUADS_PER_DRAW quads, so the indices of that
+    // many are enough for any count
+    if (std::min(count, SDF_QUADS_PER_DRAW) > sdfQuadCapacity) {
+        updateSdfIndices(std::min(count, SDF_QUADS_PER_DRAW));
+    }
+
+    glState.useProgram(sdfProgram);
+    updateModelview();
+    uploadTransform(sdfTransformUniform, modelview);
+    glState.enable(GL_BLEND, true);
+    glState.bindBuffer(GL_ARRAY_BUFFER, sdfVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sdfVertices.size() * sizeof(SdfVertex), sdfVertices.data(), GL_STREAM_DRAW);
+    PINTA_COUNT(BUFFER_UPLOADS, 1);
+    PINTA_COUNT(BYTES_UPLOADED, sdfVertices.size() * sizeof(SdfVertex));
+    glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, sdfIndexBuffer);
+    glState.vertexAttribArray(COLOR_ATTRIBUTE, true);
+    glState.vertexAttribArray(CORNER_ATTRIBUTE, true);
+    glState.vertexAttribArray(SHAPE_ATTRIBUTE, true);
+    for (size_t first = 0; first < count; first += SDF_QUADS_PER_DRAW) {
+        // The indices start from zero, so each draw starts the attributes
+        // at its first quad
+        const uint8_t *base = reinterpret_cast<const uint8_t *>(first * 4 * sizeof(SdfVertex));
+        glState.vertexAttribPointer(POS_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, sizeof(SdfVertex), base + offsetof(SdfVertex, position));
+        glState.vertexAttribPointer(CORNER_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, sizeof(SdfVertex), base + offsetof(SdfVertex, corner));
+        glState.vertexAttribPointer(SHAPE_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(SdfVertex), base + offsetof(SdfVertex, shape));
+        glState.vertexAttribPointer(COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SdfVertex), base + offsetof(SdfVertex, color));
+        GLsizei indexCount = std::min(count - first, SDF_QUADS_PER_DRAW) * 6;
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, nullptr);
+        drawCalls++;
+        PINTA_COUNT(DRAW_CALLS, 1);
+    }
+    glState.vertexAttribArray(CORNER_ATTRIBUTE, false);
+    glState.vertexAttribArray(SHAPE_ATTRIBUTE, false);
+    glState.enable(GL_BLEND, false);
+}
+
 void Renderer::enableStencilTest(bool enable)
 {
-    if (enable) {
-		glEnable(GL_STENCIL_TEST);
-        glStencilFunc(GL_EQUAL, 1, 1);
-	} else {
-        glStencilFunc(GL_ALWAYS, 1, 1);
-		if (!updateStencilEnabled) {
-			glDisable(GL_STENCIL_TEST);
-		}
-	}
-	stencilTestEnabled = enable;
+    stencilTestEnabled = enable;
+    applyStencil();
+}
+
+void Renderer::release(const Mesh *mesh)
+{
+    auto it = renderedMeshes.find(mesh);
+    if (it != renderedMeshes.end()) {
+        freeBuffers(it->second);
+        renderedMeshes.erase(it);
+    }
+}
+
+void Renderer::release(const MeshStore *store)
+{
+    auto it = storedMeshes.find(store);
+    if (it != storedMeshes.end()) {
+        for (const RenderedMesh &renderedMesh: it->second) {
+            freeBuffers(renderedMesh);
+        }
+        storedMeshes.erase(it);
+    }
+}
+
+void Renderer::release(const MeshBatch *batch)
+{
+    auto it = renderedBatches.find(batch);
+    if (it != renderedBatches.end()) {
+        freeBuffers(it->second);
+        renderedBatches.erase(it);
+    }
+}
+
+void Renderer::popClip()
+{
+    if (clips.empty()) {
+        throw RendererError("popClip without a matching pushClip");
+    }
+    Clip clip = clips.back();
+    clips.pop_back();
+    if (clip.mask) {
+        // Take the pixels of the mask back to the count of the enclosing clip
+        drawClipMask(clip, GL_DECR);
+        stencilClips--;
+        applyStencil();
+    }
+    applyScissor();
+}
+
+void Renderer::popTransform()
+{
+    if (transformStack.empty()) {
+        throw RendererError("popTransform without a matching pushTransform");
+    }
+    transformation = transformStack.back();
+    transformStack.pop_back();
+    transformationChanged = true;
+}
+
+void Renderer::pushClip(const BoundingBox &area)
+{
+    updateModelview();
+    if (modelview.get(0, 1) != 0.0 || modelview.get(1, 0) != 0.0) {
+        // A rotated rectangle goes through the stencil, with a mesh per level
+        if (clipRectangles.size() <= static_cast<size_t>(stencilClips)) {
+            clipRectangles.emplace_back(new Mesh(GL_TRIANGLES));
+            clipRectangles.back()->setIndices({0, 1, 2, 0, 2, 3});
+        }
+        Mesh &rectangle = *clipRectangles[stencilClips];
+        const glm::vec2 &min = area.getMin();
+        const glm::vec2 &max = area.getMax();
+        rectangle.setVertices({Vertex(min.x, min.y), Vertex(max.x, min.y), Vertex(max.x, max.y), Vertex(min.x, max.y)});
+        pushClip(&rectangle);
+        return;
+    }
+
+    // The window coordinates of the area, cut by the enclosing clip
+    glm::vec2 corners[2] = {modelview.apply(area.getMin()), modelview.apply(area.getMax())};
+    GLint box[4];
+    for (int axis = 0; axis < 2; axis++) {
+        int size = axis ? viewportHeight : viewportWidth;
+        float first = std::min(corners[0][axis], corners[1][axis]);
+        float last = std::max(corners[0][axis], corners[1][axis]);
+        box[axis] = std::lround((first + 1.0) * size / 2.0);
+        box[axis + 2] = std::lround((last + 1.0) * size / 2.0);
+        box[axis] = std::max(box[axis], getScissor()[axis]);
+        box[axis + 2] = std::min(box[axis + 2], getScissor()[axis + 2]);
+        box[axis + 2] = std::max(box[axis], box[axis + 2]);
+    }
+    Clip clip = {nullptr, transformation, {box[0], box[1], box[2], box[3]}};
+    clips.push_back(clip);
+    applyScissor();
+}
+
+void Renderer::pushClip(const Mesh *mask)
+{
+    if (stencilClips == static_cast<int>(CLIP_BITS)) {
+        throw RendererError("too many nested clips");
+    }
+    Clip clip = {mask, transformation, {0, 0, 0, 0}};
+    std::copy(getScissor(), getScissor() + 4, clip.scissor);
+
+    // Count the mask in the pixels that are inside all the enclosing clips
+    drawClipMask(clip, GL_INCR);
+    clips.push_back(clip);
+    stencilClips++;
+    applyStencil();
+}
+
+void Renderer::pushTransform()
+{
+    transformStack.push_back(transformation);
 }
 
 void Renderer::resetTransformations()
 {
-    transformationMatrix = projectionMatrix;
+    // The saved transformations are kept, so that pushes and pops still match
+    transformation = Transform2D();
+    transformationChanged = true;
+}
+
+void Renderer::rotate(float angle)
+{
+    transformation.rotate(angle);
+    transformationChanged = true;
 }
 
 void Renderer::scale(const glm::vec2& scaleFactor)
 {
-    transformationMatrix = glm::scale(transformationMatrix, glm::vec3(scaleFactor.x, scaleFactor.y, 1.0));
-    glUniformMatrix4fv(modelviewUniform, 1, GL_FALSE, &transformationMatrix[0][0]);
+    transformation.scale(scaleFactor);
+    transformationChanged = true;
 }
 
 void Renderer::setBackgroundColor(const glm::vec3 &color)
@@ -106,51 +548,392 @@ void Renderer::setBackgroundColor(const glm::vec3 &color)
     glClearColor(color.r, color.g, color.b, 1.0);
 }
 
+void Renderer::setDamage(const BoundingBox &area)
+{
+    // Whole pixels, inside the viewport
+    std::fill(damage, damage + 4, 0);
+    if (!area.isEmpty()) {
+        const glm::vec2 &min = area.getMin();
+        const glm::vec2 &max = area.getMax();
+        damage[0] = std::lround(std::min(std::max(std::floor(min.x), 0.0f), static_cast<float>(viewportWidth)));
+        damage[1] = std::lround(std::min(std::max(std::floor(min.y), 0.0f), static_cast<float>(viewportHeight)));
+        damage[2] = std::lround(std::min(std::max(std::ceil(max.x), static_cast<float>(damage[0])), static_cast<float>(viewportWidth)));
+        damage[3] = std::lround(std::min(std::max(std::ceil(max.y), static_cast<float>(damage[1])), static_cast<float>(viewportHeight)));
+    }
+    damageSet = true;
+    if (clips.empty()) {
+        applyScissor();
+    }
+}
+
+void Renderer::setTime(float time)
+{
+    // The shapes have a program of their own, without animations
+    glState.useProgram(shaderProgram);
+    glState.uniform(timeUniform, time);
+}
+
 void Renderer::translate(const glm::vec2& position)
 {
-    transformationMatrix = glm::translate(transformationMatrix, glm::vec3(position.x, position.y, 0.0));
-    glUniformMatrix4fv(modelviewUniform, 1, GL_FALSE, &transformationMatrix[0][0]);
+    transformation.translate(position);
+    transformationChanged = true;
 }
 
 void Renderer::updateColor(bool update)
 {
-    glColorMask(update, update, update, update);
+    glState.colorMask(update);
+    updateColorEnabled = update;
 }
 
 void Renderer::updateStencil(bool update)
 {
-    if (update) {
-		glEnable(GL_STENCIL_TEST);
-		glStencilOp(GL_REPLACE, GL_REPLACE, GL_REPLACE);
-	} else {
-		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-		if (!stencilTestEnabled) {
-			glDisable(GL_STENCIL_TEST);
-		}
-	}
-	updateStencilEnabled = update;
+    updateStencilEnabled = update;
+    applyStencil();
+}
+
+void Renderer::addItemToBatch(const DrawItem &item, const Mesh *mesh)
+{
+    const std::vector<Vertex> &vertices = mesh->getVertices();
+    if (itemVertices.size() + vertices.size() > ITEM_BATCH_VERTICES) {
+        drawItemBatch();
+    }
+
+    triangulate(mesh->getPrimitive(), mesh->getIndices().data(), mesh->getIndices().size(), itemVertices.size(),
+        triangleIndices);
+    itemIndices.insert(itemIndices.end(), triangleIndices.begin(), triangleIndices.end());
+    for (const Vertex &vertex: vertices) {
+        const Color &color = vertex.color;
+        itemVertices.emplace_back(vertex.position[0] * item.scale.x + item.position.x,
+            vertex.position[1] * item.scale.y + item.position.y,
+            Color((color.getRed() * item.color.getRed() + 127) / 255, (color.getGreen() * item.color.getGreen() + 127) / 255,
+                (color.getBlue() * item.color.getBlue() + 127) / 255, (color.getAlpha() * item.color.getAlpha() + 127) / 255));
+    }
+}
+
+void Renderer::addToBatch(const RenderedMesh &renderedMesh)
+{
+    if (!renderedMesh.getParts().empty()) {
+        for (const RenderedMesh &part: renderedMesh.getParts()) {
+            addToBatch(part);
+        }
+        return;
+    }
+
+    // Consecutive meshes whose indices are contiguous in the index buffer are
+    // drawn with a single call
+    if (batch && isBatchable(batch->getPrimitive())
+            && batch->getPrimitive() == renderedMesh.getPrimitive()
+            && batch->getFormat() == renderedMesh.getFormat()
+            && (batch->getFormat() != RenderedMesh::PACKED || batch->getColor() == renderedMesh.getColor())
+            && batch->getVertexBase() == renderedMesh.getVertexBase()
+            && batch->getFirstIndex() + batchIndexCount == renderedMesh.getFirstIndex()) {
+        batchIndexCount += renderedMesh.getIndexCount();
+    } else {
+        drawBatch();
+        batch = &renderedMesh;
+        batchIndexCount = renderedMesh.getIndexCount();
+    }
+}
+
+void Renderer::applyTransformation()
+{
+    // The uniforms of the immediate calls, only sent when a draw needs them
+    glState.useProgram(shaderProgram);
+    updateModelview();
+    uploadTransform(transformUniform, modelview);
+    glState.uniform(colorUniform, 1.0, 1.0, 1.0, 1.0);
+    glState.uniformVectors(animationUniform, ShaderAnimation::UNIFORMS, &NO_ANIMATION.getUniforms()[0].x);
+}
+
+void Renderer::applyScissor()
+{
+    const GLint *box = getScissor();
+    bool scissorTest = box[0] > 0 || box[1] > 0 || box[2] < viewportWidth || box[3] < viewportHeight;
+    glState.enable(GL_SCISSOR_TEST, scissorTest);
+    if (scissorTest) {
+        glState.scissor(box[0], box[1], box[2] - box[0], box[3] - box[1]);
+    }
+}
+
+void Renderer::applyState(const DrawState &state)
+{
+    if (state.isUpdateStencilEnabled() != updateStencilEnabled) {
+        updateStencil(state.isUpdateStencilEnabled());
+    }
+    if (state.isStencilTestEnabled() != stencilTestEnabled) {
+        enableStencilTest(state.isStencilTestEnabled());
+    }
+    if (state.isUpdateColorEnabled() != updateColorEnabled) {
+        updateColor(state.isUpdateColorEnabled());
+    }
+}
+
+void Renderer::applyStencil(GLenum clipOperation)
+{
+    // Drawing a clip mask only tests and writes the clip count
+    bool drawingClip = clipOperation != GL_KEEP;
+    if (!drawingClip && !stencilTestEnabled && !updateStencilEnabled && stencilClips == 0) {
+        glState.enable(GL_STENCIL_TEST, false);
+        return;
+    }
+
+    glState.enable(GL_STENCIL_TEST, true);
+    GLuint testedBits = (drawingClip || stencilClips > 0 ? CLIP_BITS : 0) | (stencilTestEnabled && !drawingClip ? MASK_BIT : 0);
+    glState.stencilFunc(testedBits ? GL_EQUAL : GL_ALWAYS, MASK_BIT | stencilClips, testedBits);
+    if (drawingClip) {
+        glState.stencilWriteMask(CLIP_BITS);
+        glState.stencilOp(GL_KEEP, GL_KEEP, clipOperation);
+    } else if (updateStencilEnabled) {
+        // Outside of the clips the mask is not written
+        glState.stencilWriteMask(MASK_BIT);
+        glState.stencilOp(stencilClips ? GL_KEEP : GL_REPLACE, GL_REPLACE, GL_REPLACE);
+    } else {
+        glState.stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    }
+}
+
+RenderedMesh::Format Renderer::chooseFormat(const Vertex *vertices, size_t count) const
+{
+    if (!compactVertices || count == 0) {
+        return RenderedMesh::FULL;
+    }
+
+    // The color goes to a uniform if all the vertices share it
+    float limit = 32767 / RenderedMesh::POSITION_SCALE;
+    bool uniformColor = true;
+    for (const Vertex *vertex = vertices; vertex < vertices + count; vertex++) {
+        if (std::abs(vertex->position[0]) > limit || std::abs(vertex->position[1]) > limit) {
+            return RenderedMesh::FULL;
+        }
+        uniformColor = uniformColor && vertex->color == vertices[0].color;
+    }
+    // The color of small meshes stays in their vertices even if they share
+    // one, so that meshes of different colors are still drawn together
+    return (uniformColor && count >= PACKED_MIN_VERTICES) ? RenderedMesh::PACKED : RenderedMesh::PACKED_COLOR;
 }
 
-void Renderer::createShaderProgram()
+void Renderer::compactBuffers()
 {
-    GLuint vertexShader = loadShader(GL_VERTEX_SHADER, VERTEX_SHADER_TEXT);
-    GLuint fragmentShader = loadShader(GL_FRAGMENT_SHADER, FRAGMENT_SHADER_TEXT);
-    shaderProgram = glCreateProgram();
-    if (!shaderProgram) {
+    // Meshes are moved to the holes left by the released ones in passes over
+    // the meshes there were when the pass started, a few of them per frame. A
+    // pass only starts after a slice was freed below the end of a buffer,
+    // including by the moves of the previous pass, so once a pass moves
+    // nothing the holes that no mesh fits in cost nothing more.
+    if (compactionCursor == compactionEntries.size()) {
+        bool compactable = indexArena.isCompactable();
+        for (const std::unique_ptr<BufferArena> &vertexArena: vertexArenas) {
+            compactable = compactable || vertexArena->isCompactable();
+        }
+        if (!compactable) {
+            return;
+        }
+        indexArena.resetCompactable();
+        for (const std::unique_ptr<BufferArena> &vertexArena: vertexArenas) {
+            vertexArena->resetCompactable();
+        }
+        compactionEntries.clear();
+        compactionCursor = 0;
+        for (const auto &renderedMesh: renderedMeshes) {
+            compactionEntries.push_back({renderedMesh.first, nullptr, 0});
+        }
+        for (const auto &renderedStore: storedMeshes) {
+            for (uint32_t slot = 0; slot < renderedStore.second.size(); slot++) {
+                if (renderedStore.second[slot].getGeneration()) {
+                    compactionEntries.push_back({nullptr, renderedStore.first, slot});
+                }
+            }
+        }
+    }
+
+    PINTA_PHASE(UPLOAD);
+    int relocations = 0;
+    for (int checks = 0; checks < COMPACTION_CHECKS_PER_FRAME && relocations < RELOCATIONS_PER_FRAME
+            && compactionCursor < compactionEntries.size(); checks++) {
+        // Meshes released since the pass started are skipped
+        RenderedMesh *renderedMesh = findCompactionEntry(compactionEntries[compactionCursor++]);
+        if (renderedMesh) {
+            relocations += relocateMesh(*renderedMesh);
+        }
+    }
+}
+
+GLuint Renderer::createProgram(const char *vertexShaderText, const char *fragmentShaderText)
+{
+    GLuint vertexShader = loadShader(GL_VERTEX_SHADER, vertexShaderText);
+    GLuint fragmentShader = loadShader(GL_FRAGMENT_SHADER, fragmentShaderText);
+    GLuint program = glCreateProgram();
+    if (!program) {
         throw RendererError("error on glCreateProgram");
     }
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    linkProgram(program);
+    return program;
+}
+
+void Renderer::createSdfProgram()
+{
+    sdfProgram = createProgram(SDF_VERTEX_SHADER_TEXT, SDF_FRAGMENT_SHADER_TEXT);
+    sdfTransformUniform = glGetUniformLocation(sdfProgram, "u_transform");
+    glState.useProgram(sdfProgram);
+    glUniform2f(glGetUniformLocation(sdfProgram, "u_pixelSize"), 2.0 / viewportWidth, 2.0 / viewportHeight);
+    glGenBuffers(1, &sdfVertexBuffer);
+    glGenBuffers(1, &sdfIndexBuffer);
 }
 
-void Renderer::destroyBuffers()
+void Renderer::drawBatch()
 {
-    if (vertexBuffer) {
-        glDeleteBuffers(1, &vertexBuffer);
-        glDeleteBuffers(1, &indexBuffer);
+    if (batch) {
+        PINTA_PHASE(SUBMIT);
+        float scale = (batch->getFormat() == RenderedMesh::FULL) ? 1.0 : 1.0 / RenderedMesh::POSITION_SCALE;
+        glState.uniform(positionScaleUniform, scale);
+        vertexArenas[batch->getFormat()]->bind();
+        indexArena.bind();
+        glState.vertexAttribPointer(POS_ATTRIBUTE, 2, batch->getPositionType(), GL_FALSE, batch->getStride(),
+            batch->getPositionOffset());
+        if (batch->getFormat() == RenderedMesh::PACKED) {
+            glState.vertexAttribArray(COLOR_ATTRIBUTE, false);
+            const Color &color = batch->getColor();
+            glState.vertexAttrib(COLOR_ATTRIBUTE, color.getRed() / 255.0, color.getGreen() / 255.0, color.getBlue() / 255.0,
+                color.getAlpha() / 255.0);
+        } else {
+            glState.vertexAttribArray(COLOR_ATTRIBUTE, true);
+            glState.vertexAttribPointer(COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, batch->getStride(),
+                batch->getColorOffset());
+        }
+        glDrawElements(batch->getPrimitive(), batchIndexCount, indexType, batch->getIndexOffset(indexArena.getElementSize()));
+        drawCalls++;
+        PINTA_COUNT(DRAW_CALLS, 1);
+        batch = nullptr;
+        batchIndexCount = 0;
     }
-    vertexBuffer = 0;
-    indexBuffer = 0;
+}
+
+void Renderer::drawClipMask(const Clip &clip, GLenum operation)
+{
+    // The mask is drawn with the transformation it was pushed with
+    Transform2D current = transformation;
+    transformation = clip.transformation;
+    transformationChanged = true;
+    glState.colorMask(false);
+    applyStencil(operation);
+    applyTransformation();
+    addToBatch(prepareMesh(clip.mask));
+    drawBatch();
+    transformation = current;
+    transformationChanged = true;
+    glState.colorMask(updateColorEnabled);
+    applyStencil();
+}
+
+void Renderer::drawItemBatch()
+{
+    // The batched meshes are drawn first, with the uniforms they were added
+    // with
+    drawBatch();
+    if (itemIndices.empty()) {
+        return;
+    }
+
+    PINTA_PHASE(SUBMIT);
+    if (!itemVertexBuffer) {
+        glGenBuffers(1, &itemVertexBuffer);
+        glGenBuffers(1, &itemIndexBuffer);
+    }
+    uploadTransform(transformUniform, modelview);
+    glState.uniform(colorUniform, 1.0, 1.0, 1.0, 1.0);
+    glState.uniform(positionScaleUniform, 1.0);
+    glState.uniformVectors(animationUniform, ShaderAnimation::UNIFORMS, &NO_ANIMATION.getUniforms()[0].x);
+    uniformItem = nullptr;
+    glState.bindBuffer(GL_ARRAY_BUFFER, itemVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, itemVertices.size() * sizeof(Vertex), itemVertices.data(), GL_STREAM_DRAW);
+    glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, itemIndexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, itemIndices.size() * indexArena.getElementSize(), packIndices(itemIndices),
+        GL_STREAM_DRAW);
+    PINTA_COUNT(BUFFER_UPLOADS, 2);
+    PINTA_COUNT(BYTES_UPLOADED, itemVertices.size() * sizeof(Vertex) + itemIndices.size() * indexArena.getElementSize());
+    glState.vertexAttribPointer(POS_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+        reinterpret_cast<const void *>(offsetof(Vertex, position)));
+    glState.vertexAttribArray(COLOR_ATTRIBUTE, true);
+    glState.vertexAttribPointer(COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex),
+        reinterpret_cast<const void *>(offsetof(Vertex, color)));
+    glDrawElements(GL_TRIANGLES, itemIndices.size(), indexType, nullptr);
+    drawCalls++;
+    PINTA_COUNT(DRAW_CALLS, 1);
+    itemVertices.clear();
+    itemIndices.clear();
+}
+
+void Renderer::evictMeshes()
+{
+    for (auto it = renderedMeshes.begin(); it != renderedMeshes.end();) {
+        if (frame - it->second.getLastFrame() > evictionAge) {
+            freeBuffers(it->second);
+            it = renderedMeshes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto &renderedStore: storedMeshes) {
+        for (RenderedMesh &renderedMesh: renderedStore.second) {
+            if (renderedMesh.getGeneration() && frame - renderedMesh.getLastFrame() > evictionAge) {
+                freeBuffers(renderedMesh);
+                renderedMesh = RenderedMesh();
+            }
+        }
+    }
+    for (auto it = renderedBatches.begin(); it != renderedBatches.end();) {
+        if (frame - it->second.lastFrame > evictionAge) {
+            freeBuffers(it->second);
+            it = renderedBatches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+RenderedMesh * Renderer::findCompactionEntry(const CompactionEntry &entry)
+{
+    if (entry.store) {
+        auto it = storedMeshes.find(entry.store);
+        return (it != storedMeshes.end() && entry.slot < it->second.size()) ? &it->second[entry.slot] : nullptr;
+    }
+    auto it = renderedMeshes.find(entry.mesh);
+    return (it != renderedMeshes.end()) ? &it->second : nullptr;
+}
+
+void Renderer::freeBuffers(const RenderedMesh &renderedMesh)
+{
+    vertexArenas[renderedMesh.getFormat()]->free(renderedMesh.getFirstVertex(), renderedMesh.getVertexCount());
+    indexArena.free(renderedMesh.getFirstIndex(), renderedMesh.getIndexCount());
+    for (const RenderedMesh &part: renderedMesh.getParts()) {
+        freeBuffers(part);
+    }
+}
+
+void Renderer::freeBuffers(RenderedBatch &renderedBatch)
+{
+    for (const RenderedMesh &renderedMesh: renderedBatch.meshes) {
+        freeBuffers(renderedMesh);
+    }
+    renderedBatch.meshes.clear();
+    renderedBatch.generation = 0;
+}
+
+const Mesh * Renderer::getItemMesh(const DrawItem &item) const
+{
+    return item.shape ? item.shape->getMesh(modelview, item.scale, viewportWidth, viewportHeight) : item.mesh;
+}
+
+Renderer::MeshData Renderer::getMeshData(const Mesh *mesh)
+{
+    return {mesh->getPrimitive(), mesh->getVertices().data(), mesh->getVertices().size(), mesh->getIndices().data(),
+        mesh->getIndices().size(), mesh->getGeneration(), mesh->getIndexGeneration()};
+}
+
+bool Renderer::hasExtension(const char *name)
+{
+    return pinta::hasExtension(reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS)), name);
 }
 
 GLuint Renderer::loadShader(GLenum shaderType, const char *shaderSource)
@@ -182,55 +965,398 @@ GLuint Renderer::loadShader(GLenum shaderType, const char *shaderSource)
     return shader;
 }
 
-void Renderer::linkProgram()
+void Renderer::linkProgram(GLuint program)
 {
-    glBindAttribLocation(shaderProgram, POS_ATTRIBUTE, "a_position");
-    glBindAttribLocation(shaderProgram, COLOR_ATTRIBUTE, "a_color");
-    glEnableVertexAttribArray(POS_ATTRIBUTE);
-    glEnableVertexAttribArray(COLOR_ATTRIBUTE);
-    glLinkProgram(shaderProgram);
+    // Both programs share the attribute locations
+    glBindAttribLocation(program, POS_ATTRIBUTE, "a_position");
+    glBindAttribLocation(program, COLOR_ATTRIBUTE, "a_color");
+    glBindAttribLocation(program, CORNER_ATTRIBUTE, "a_corner");
+    glBindAttribLocation(program, SHAPE_ATTRIBUTE, "a_shape");
+    glLinkProgram(program);
 
     GLint linked;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &linked);
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
     if (!linked) {
         GLint infoLen = 0;
         std::string strInfoLog;
 
-        glGetProgramiv(shaderProgram, GL_INFO_LOG_LENGTH, &infoLen);
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &infoLen);
         if (infoLen > 1) {
             char *infoLog = new char[infoLen];
-            glGetProgramInfoLog(shaderProgram, infoLen, nullptr, infoLog);
+            glGetProgramInfoLog(program, infoLen, nullptr, infoLog);
             strInfoLog = infoLog;
             delete[] infoLog;
         }
-        glDeleteProgram(shaderProgram);
+        glDeleteProgram(program);
         throw RendererError(std::string("error linking program:\n") + strInfoLog);
     }
 }
 
-void Renderer::rebuildVertexBuffers(const std::list<const Mesh *> &meshes)
+const void * Renderer::packIndices(const std::vector<GLuint> &indices)
 {
-    std::vector<Vertex> vertices;
-    std::vector<GLushort> indices;
+    if (indexType == GL_UNSIGNED_INT) {
+        return indices.data();
+    }
 
-    renderedMeshes.clear();
-    int vertexOffset = 0;
-    int indexOffset = 0;
-    for (const Mesh *mesh: meshes) {
-        vertices.insert(vertices.end(), mesh->getVertices().begin(), mesh->getVertices().end());
-        indices.insert(indices.end(), mesh->getIndices().begin(), mesh->getIndices().end());
-        renderedMeshes[mesh] = RenderedMesh(mesh, vertexOffset, indexOffset);
-        vertexOffset = vertices.size();
-        indexOffset = indices.size();
-    }
-
-    destroyBuffers();
-    glGenBuffers(1, &vertexBuffer);
-    glGenBuffers(1, &indexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    shortIndices.assign(indices.begin(), indices.end());
+    return shortIndices.data();
+}
+
+const void * Renderer::packVertices(const Vertex *vertices, size_t count, RenderedMesh::Format format)
+{
+    if (format == RenderedMesh::FULL) {
+        return vertices;
+    }
+
+    GLsizei size = RenderedMesh::getVertexSize(format);
+    packedVertices.resize(count * size);
+    uint8_t *packedVertex = packedVertices.data();
+    for (size_t i = 0; i < count; i++) {
+        const Vertex &vertex = vertices[i];
+        GLshort position[2] = {
+            static_cast<GLshort>(std::lround(vertex.position[0] * RenderedMesh::POSITION_SCALE)),
+            static_cast<GLshort>(std::lround(vertex.position[1] * RenderedMesh::POSITION_SCALE))
+        };
+        std::copy(reinterpret_cast<const uint8_t *>(position), reinterpret_cast<const uint8_t *>(position + 2), packedVertex);
+        if (format == RenderedMesh::PACKED_COLOR) {
+            std::copy(reinterpret_cast<const uint8_t *>(&vertex.color), reinterpret_cast<const uint8_t *>(&vertex.color + 1),
+                packedVertex + sizeof(position));
+        }
+        packedVertex += size;
+    }
+    return packedVertices.data();
+}
+
+RenderedMesh & Renderer::prepareMesh(const Mesh *mesh)
+{
+    return prepareMesh(mesh, renderedMeshes[mesh]);
+}
+
+RenderedMesh & Renderer::prepareMesh(const Mesh *mesh, RenderedMesh &renderedMesh)
+{
+    // Generations are unique among meshes, so a record made for another mesh
+    // never looks up to date
+    if (renderedMesh.getGeneration() != mesh->getGeneration()) {
+        PINTA_PHASE(UPLOAD);
+        updateMesh(getMeshData(mesh), renderedMesh);
+    }
+    renderedMesh.setLastFrame(frame);
+    return renderedMesh;
+}
+
+void Renderer::rebaseIndices(const RenderedMesh &renderedMesh, int vertexBase, int firstVertex)
+{
+    // Keep the indices pointing to the vertices of the mesh after they are moved
+    int shift = (firstVertex - vertexBase) - (renderedMesh.getFirstVertex() - renderedMesh.getVertexBase());
+    const uint8_t *indices = indexArena.getData(renderedMesh.getFirstIndex());
+    if (indexType == GL_UNSIGNED_INT) {
+        triangleIndices.assign(reinterpret_cast<const GLuint *>(indices), reinterpret_cast<const GLuint *>(indices) + renderedMesh.getIndexCount());
+    } else {
+        triangleIndices.assign(reinterpret_cast<const GLushort *>(indices), reinterpret_cast<const GLushort *>(indices) + renderedMesh.getIndexCount());
+    }
+    for (GLuint &index: triangleIndices) {
+        index += shift;
+    }
+    indexArena.upload(renderedMesh.getFirstIndex(), triangleIndices.size(), packIndices(triangleIndices));
+}
+
+bool Renderer::relocateMesh(RenderedMesh &renderedMesh)
+{
+    // Split meshes are left where they are
+    if (!renderedMesh.getParts().empty()) {
+        return false;
+    }
+
+    BufferArena &vertexArena = *vertexArenas[renderedMesh.getFormat()];
+    if (vertexArena.isFragmented()) {
+        int firstVertex = vertexArena.relocate(renderedMesh.getFirstVertex(), renderedMesh.getVertexCount());
+        if (firstVertex != renderedMesh.getFirstVertex()) {
+            int vertexBase = getPageStart(firstVertex);
+            rebaseIndices(renderedMesh, vertexBase, firstVertex);
+            renderedMesh.setFirstVertex(vertexBase, firstVertex);
+            return true;
+        }
+    }
+    if (indexArena.isFragmented()) {
+        int firstIndex = indexArena.relocate(renderedMesh.getFirstIndex(), renderedMesh.getIndexCount());
+        if (firstIndex != renderedMesh.getFirstIndex()) {
+            renderedMesh.setFirstIndex(firstIndex);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Renderer::splitMesh(const MeshData &mesh, RenderedMesh &renderedMesh)
+{
+    const Vertex *vertices = mesh.vertices;
+    RenderedMesh::Format format = chooseFormat(vertices, mesh.vertexCount);
+    Color color = (format == RenderedMesh::PACKED) ? vertices[0].color : Color(0, 0, 0);
+    BufferArena &vertexArena = *vertexArenas[format];
+    GLenum primitive = triangulate(mesh.primitive, mesh.indices, mesh.indexCount, 0, triangleIndices);
+    size_t primitiveSize = getPrimitiveSize(primitive);
+
+    unsigned int lastFrame = renderedMesh.getLastFrame();
+    freeBuffers(renderedMesh);
+    renderedMesh = RenderedMesh(mesh.generation, mesh.indexGeneration, primitive, format, color, 0, 0, 0, 0, 0);
+    renderedMesh.setLastFrame(lastFrame);
+
+    // Fill each part with whole primitives until its vertices take a page
+    size_t first = 0;
+    while (first + primitiveSize <= triangleIndices.size()) {
+        partVertices.clear();
+        partIndices.clear();
+        partSources.clear();
+        partVertexMap.assign(mesh.vertexCount, -1);
+        for (; first + primitiveSize <= triangleIndices.size(); first += primitiveSize) {
+            size_t newVertices = 0;
+            for (size_t i = first; i < first + primitiveSize; i++) {
+                newVertices += (partVertexMap[triangleIndices[i]] < 0);
+            }
+            if (partVertices.size() + newVertices > static_cast<size_t>(vertexPageSize)) {
+                break;
+            }
+            for (size_t i = first; i < first + primitiveSize; i++) {
+                int &partVertex = partVertexMap[triangleIndices[i]];
+                if (partVertex < 0) {
+                    partVertex = partVertices.size();
+                    partVertices.push_back(vertices[triangleIndices[i]]);
+                    partSources.push_back(triangleIndices[i]);
+                }
+                partIndices.push_back(partVertex);
+            }
+        }
+
+        int firstVertex = vertexArena.allocate(partVertices.size());
+        int vertexBase = getPageStart(firstVertex);
+        vertexArena.upload(firstVertex, partVertices.size(), packVertices(partVertices.data(), partVertices.size(), format));
+        for (GLuint &index: partIndices) {
+            index += firstVertex - vertexBase;
+        }
+        int firstIndex = indexArena.allocate(partIndices.size());
+        indexArena.upload(firstIndex, partIndices.size(), packIndices(partIndices));
+        renderedMesh.addPart(RenderedMesh(mesh.generation, mesh.indexGeneration, primitive, format, color, vertexBase,
+            firstVertex, partVertices.size(), firstIndex, partIndices.size()), partSources);
+    }
+}
+
+void Renderer::updateModelview()
+{
+    // The transformations are composed once per change, not once per draw
+    if (transformationChanged) {
+        modelview = projection * transformation;
+        transformationChanged = false;
+    }
+}
+
+void Renderer::updateSdfIndices(size_t quads)
+{
+    // The same two triangles for every quad
+    std::vector<GLushort> indices;
+    indices.reserve(quads * 6);
+    for (size_t quad = 0; quad < quads; quad++) {
+        GLushort first = quad * 4;
+        indices.insert(indices.end(), {first, static_cast<GLushort>(first + 1), static_cast<GLushort>(first + 2), first,
+            static_cast<GLushort>(first + 2), static_cast<GLushort>(first + 3)});
+    }
+    glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, sdfIndexBuffer);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+    sdfQuadCapacity = quads;
+}
+
+void Renderer::uploadBatch(const MeshBatch &batch, RenderedBatch &renderedBatch)
+{
+    freeBuffers(renderedBatch);
+    renderedBatch.generation = batch.getGeneration();
+    renderedBatch.meshes.resize(batch.getSize());
+
+    const std::vector<Vertex> &vertices = batch.getVertices();
+    const std::vector<GLuint> &indices = batch.getIndices();
+    RenderedMesh::Format format = chooseFormat(vertices.data(), vertices.size());
+    Color color = (format == RenderedMesh::PACKED) ? vertices[0].color : Color(0, 0, 0);
+    BufferArena &vertexArena = *vertexArenas[format];
+
+    // The meshes go in runs that fit in a page of the vertex buffer, each one
+    // uploaded with one call for its vertices and one for its indices
+    size_t first = 0;
+    while (first < batch.getSize()) {
+        if (vertexPageSize && batch.getVertexCount(first) > static_cast<size_t>(vertexPageSize)) {
+            MeshData mesh = {batch.getPrimitive(first), vertices.data() + batch.getFirstVertex(first), batch.getVertexCount(first),
+                indices.data() + batch.getFirstIndex(first), batch.getIndexCount(first), 0, 0};
+            splitMesh(mesh, renderedBatch.meshes[first]);
+            first++;
+            continue;
+        }
+        size_t last = first + 1;
+        while (last < batch.getSize() && (!vertexPageSize
+                || batch.getFirstVertex(last + 1) - batch.getFirstVertex(first) <= static_cast<size_t>(vertexPageSize))) {
+            last++;
+        }
+
+        size_t runVertex = batch.getFirstVertex(first);
+        size_t vertexCount = batch.getFirstVertex(last) - runVertex;
+        int firstVertex = vertexArena.allocate(vertexCount);
+        int vertexBase = getPageStart(firstVertex);
+        vertexArena.upload(firstVertex, vertexCount, packVertices(vertices.data() + runVertex, vertexCount, format));
+        batchIndices.clear();
+        for (size_t mesh = first; mesh < last; mesh++) {
+            int meshVertex = firstVertex + (batch.getFirstVertex(mesh) - runVertex);
+            GLenum primitive = triangulate(batch.getPrimitive(mesh), indices.data() + batch.getFirstIndex(mesh),
+                batch.getIndexCount(mesh), meshVertex - vertexBase, triangleIndices);
+            renderedBatch.meshes[mesh] = RenderedMesh(0, 0, primitive, format, color, vertexBase, meshVertex,
+                batch.getVertexCount(mesh), batchIndices.size(), triangleIndices.size());
+            batchIndices.insert(batchIndices.end(), triangleIndices.begin(), triangleIndices.end());
+        }
+        int firstIndex = indexArena.allocate(batchIndices.size());
+        indexArena.upload(firstIndex, batchIndices.size(), packIndices(batchIndices));
+        for (size_t mesh = first; mesh < last; mesh++) {
+            RenderedMesh &renderedMesh = renderedBatch.meshes[mesh];
+            renderedMesh.setFirstIndex(firstIndex + renderedMesh.getFirstIndex());
+        }
+        first = last;
+    }
 }
 
-}
\ No newline at end of file
+void Renderer::uploadTransform(GLint location, const Transform2D &transform)
+{
+    // The two rows of the affine matrix, padded to vec4
+    GLfloat rows[8] = {
+        transform.get(0, 0), transform.get(0, 1), transform.get(0, 2), 0.0,
+        transform.get(1, 0), transform.get(1, 1), transform.get(1, 2), 0.0
+    };
+    glState.uniformVectors(location, 2, rows);
+}
+
+void Renderer::updateMesh(const MeshData &mesh, RenderedMesh &renderedMesh)
+{
+    const Vertex *vertices = mesh.vertices;
+    size_t vertexCount = mesh.vertexCount;
+    if (vertexPageSize && vertexCount > static_cast<size_t>(vertexPageSize)) {
+        if (renderedMesh.getParts().empty() || renderedMesh.getIndexGeneration() != mesh.indexGeneration
+                || !updateSplitMesh(mesh, renderedMesh)) {
+            splitMesh(mesh, renderedMesh);
+        }
+        return;
+    } else if (!renderedMesh.getParts().empty()) {
+        // The mesh fits in a page again
+        unsigned int lastFrame = renderedMesh.getLastFrame();
+        freeBuffers(renderedMesh);
+        renderedMesh = RenderedMesh();
+        renderedMesh.setLastFrame(lastFrame);
+    }
+
+    RenderedMesh::Format format = chooseFormat(vertices, vertexCount);
+    Color color = (format == RenderedMesh::PACKED) ? vertices[0].color : Color(0, 0, 0);
+    const void *vertexData = packVertices(vertices, vertexCount, format);
+    BufferArena &vertexArena = *vertexArenas[format];
+
+    int vertexBase = renderedMesh.getVertexBase();
+    int firstVertex = renderedMesh.getFirstVertex();
+    bool verticesMoved = false;
+    if (format == renderedMesh.getFormat() && static_cast<int>(vertexCount) == renderedMesh.getVertexCount()) {
+        vertexArena.update(firstVertex, vertexCount, vertexData);
+    } else {
+        // The mesh doesn't fit in its slice anymore, move it elsewhere
+        vertexArenas[renderedMesh.getFormat()]->free(firstVertex, renderedMesh.getVertexCount());
+        firstVertex = vertexArena.allocate(vertexCount);
+        vertexBase = getPageStart(firstVertex);
+        vertexArena.upload(firstVertex, vertexCount, vertexData);
+        verticesMoved = true;
+    }
+
+    // Indices are stored relative to the page of the vertex buffer so that
+    // meshes in the same page can share the vertex attribute pointers. With
+    // 32 bit indices the whole buffer is a single page.
+    GLenum primitive = renderedMesh.getPrimitive();
+    int firstIndex = renderedMesh.getFirstIndex();
+    int indexCount = renderedMesh.getIndexCount();
+    if (verticesMoved || renderedMesh.getIndexGeneration() != mesh.indexGeneration) {
+        primitive = triangulate(mesh.primitive, mesh.indices, mesh.indexCount, firstVertex - vertexBase, triangleIndices);
+        if (static_cast<int>(triangleIndices.size()) == indexCount) {
+            indexArena.update(firstIndex, indexCount, packIndices(triangleIndices));
+        } else {
+            indexArena.free(firstIndex, indexCount);
+            indexCount = triangleIndices.size();
+            firstIndex = indexArena.allocate(indexCount);
+            indexArena.upload(firstIndex, indexCount, packIndices(triangleIndices));
+        }
+    }
+
+    unsigned int lastFrame = renderedMesh.getLastFrame();
+    renderedMesh = RenderedMesh(mesh.generation, mesh.indexGeneration, primitive, format, color, vertexBase, firstVertex,
+        vertexCount, firstIndex, indexCount);
+    renderedMesh.setLastFrame(lastFrame);
+}
+
+bool Renderer::updateSplitMesh(const MeshData &mesh, RenderedMesh &renderedMesh)
+{
+    // With the same indices, the parts keep their vertices and only their
+    // contents are updated, unless the format changes
+    const Vertex *vertices = mesh.vertices;
+    const std::vector<GLuint> &sources = renderedMesh.getSourceVertices();
+    RenderedMesh::Format format = chooseFormat(vertices, mesh.vertexCount);
+    Color color = (format == RenderedMesh::PACKED) ? vertices[0].color : Color(0, 0, 0);
+    if (format != renderedMesh.getFormat() || color != renderedMesh.getColor() || sources.empty()
+            || *std::max_element(sources.begin(), sources.end()) >= mesh.vertexCount) {
+        return false;
+    }
+
+    size_t source = 0;
+    for (const RenderedMesh &part: renderedMesh.getParts()) {
+        partVertices.clear();
+        for (int i = 0; i < part.getVertexCount(); i++) {
+            partVertices.push_back(vertices[sources[source++]]);
+        }
+        vertexArenas[format]->update(part.getFirstVertex(), partVertices.size(),
+            packVertices(partVertices.data(), partVertices.size(), format));
+    }
+    renderedMesh.setGeneration(mesh.generation);
+    return true;
+}
+
+bool isBatchable(GLenum primitive)
+{
+    return primitive == GL_TRIANGLES || primitive == GL_LINES || primitive == GL_POINTS;
+}
+
+int getPrimitiveSize(GLenum primitive)
+{
+    return (primitive == GL_TRIANGLES) ? 3 : (primitive == GL_LINES) ? 2 : 1;
+}
+
+GLenum triangulate(GLenum primitive, const GLuint *indices, size_t count, int base, std::vector<GLuint> &triangles)
+{
+    triangles.clear();
+    if (primitive == GL_TRIANGLE_STRIP) {
+        for (size_t i = 2; i < count; i++) {
+            // Every other triangle in a strip has its winding reversed
+            GLuint a = indices[i - 2 + (i % 2)];
+            GLuint b = indices[i - 1 - (i % 2)];
+            GLuint c = indices[i];
+            if (a != b && b != c && a != c) {
+                triangles.insert(triangles.end(), {base + a, base + b, base + c});
+            }
+        }
+        return GL_TRIANGLES;
+    } else if (primitive == GL_TRIANGLE_FAN) {
+        for (size_t i = 2; i < count; i++) {
+            triangles.insert(triangles.end(), {base + indices[0], base + indices[i - 1], base + indices[i]});
+        }
+        return GL_TRIANGLES;
+    } else if (primitive == GL_LINE_STRIP || primitive == GL_LINE_LOOP) {
+        for (size_t i = 1; i < count; i++) {
+            triangles.insert(triangles.end(), {base + indices[i - 1], base + indices[i]});
+        }
+        if (primitive == GL_LINE_LOOP && count > 2) {
+            triangles.insert(triangles.end(), {base + indices[count - 1], base + indices[0]});
+        }
+        return GL_LINES;
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            triangles.push_back(base + indices[i]);
+        }
+        return primitive;
+    }
+}
+
+}
@@ -0,0 +1,109 @@
+
+#include "pinta/renderthread.h"
+
+namespace pinta {
+
+RenderThread::RenderThread(int width, int height, std::function<void(bool)> makeCurrent, std::function<void()> swap):
+    RenderThread(width, height, makeCurrent, [swap](const BoundingBox &) {swap();})
+{
+}
+
+RenderThread::RenderThread(int width, int height, std::function<void(bool)> makeCurrent,
+    std::function<void(const BoundingBox &)> swap):
+    width(width), height(height), makeCurrent(makeCurrent), swap(swap), submitted(0), drawn(0), stopping(false),
+    failed(false)
+{
+    makeCurrent(false);
+    thread = std::thread(&RenderThread::run, this);
+}
+
+RenderThread::~RenderThread()
+{
+    // The frames already submitted are drawn before the thread ends
+    stopping = true;
+    wake();
+    thread.join();
+    // A destructor must not throw, and the context is of no use then anyway
+    try {
+        makeCurrent(true);
+    } catch (...) {
+    }
+}
+
+void RenderThread::finish()
+{
+    unsigned long frames = submitted;
+    wait([&]() {return drawn >= frames || failed;});
+    if (failed) {
+        std::rethrow_exception(error);
+    }
+}
+
+void RenderThread::submit()
+{
+    if (failed) {
+        std::rethrow_exception(error);
+    }
+
+    unsigned long frame = submitted;
+    submitted = frame + 1;
+    wake();
+
+    // The next list to record is free once the previous frame is drawn
+    wait([&]() {return drawn >= frame || failed;});
+    if (failed) {
+        std::rethrow_exception(error);
+    }
+    lists[(frame + 1) % 2].reset();
+}
+
+void RenderThread::run()
+{
+    try {
+        makeCurrent(true);
+        {
+            Renderer renderer(width, height);
+            unsigned long frame = 0;
+            while (true) {
+                wait([&]() {return submitted > frame || stopping;});
+                if (submitted == frame) {
+                    break;
+                }
+                lists[frame % 2].replay(renderer);
+                swap(renderer.getDamage());
+                drawn = ++frame;
+                wake();
+            }
+        }
+        makeCurrent(false);
+    } catch (...) {
+        error = std::current_exception();
+        failed = true;
+        wake();
+        try {
+            makeCurrent(false);
+        } catch (...) {
+        }
+    }
+}
+
+void RenderThread::wait(const std::function<bool()> &ready)
+{
+    if (ready()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, ready);
+}
+
+void RenderThread::wake()
+{
+    // Taking the mutex makes sure that a thread that has just found that it
+    // has to wait is already waiting when it is notified
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    condition.notify_all();
+}
+
+}
@@ -1,17 +1,166 @@
 
 #include "pinta/scene.h"
 
+#include <algorithm>
+
 namespace pinta {
 
-Scene::Scene()
+const float Scene::DEFAULT_CELL_SIZE = 256.0;
+
+Scene::Scene(float cellSize):
+    grid(cellSize), nextId(1), root(new SceneNode(this, nullptr, 0)), changedMeshes(new std::vector<const Mesh *>())
 {
 }
 
 Scene::~Scene()
 {
+    destroySubtree(root);
     for (Mesh *mesh: meshes) {
         delete mesh;
     }
 }
 
+SceneNode * Scene::addMesh(Mesh *mesh)
+{
+    // The scene owns the meshes added this way
+    meshes.push_back(mesh);
+    return createNode(root, mesh);
+}
+
+SceneNode * Scene::createNode(SceneNode *parent, const Mesh *mesh)
+{
+    if (!parent) {
+        parent = root;
+    }
+    SceneNode *node = new SceneNode(this, parent, nextId++);
+    parent->children.push_back(node);
+    node->setMesh(mesh);
+    return node;
+}
+
+void Scene::destroyNode(SceneNode *node)
+{
+    if (node == root) {
+        return;
+    }
+    std::vector<SceneNode *> &siblings = node->parent->children;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+    destroySubtree(node);
+}
+
+SceneNode * Scene::pick(const glm::vec2 &point)
+{
+    // Nodes that the renderer could draw in any order are taken in the order
+    // they were created
+    query(BoundingBox(point, point), pickedNodes);
+    SceneNode *picked = nullptr;
+    for (SceneNode *node: pickedNodes) {
+        if (!picked || !node->getDrawItem().isDrawnBefore(picked->getDrawItem())) {
+            picked = node;
+        }
+    }
+    return picked;
+}
+
+void Scene::query(const BoundingBox &area, std::vector<SceneNode *> &nodes)
+{
+    update();
+    grid.query(area, nodes);
+}
+
+void Scene::update()
+{
+    // The meshes no node draws anymore may still be listed
+    for (const Mesh *mesh: *changedMeshes) {
+        auto meshNode = meshNodes.find(mesh);
+        if (meshNode != meshNodes.end() && meshNode->second.generation != mesh->getGeneration()) {
+            meshNode->second.generation = mesh->getGeneration();
+            for (SceneNode *node: meshNode->second.nodes) {
+                node->invalidate();
+            }
+        }
+    }
+    changedMeshes->clear();
+    for (SceneNode *node: dirtyNodes) {
+        // Refreshing an ancestor already refreshed its subtree
+        if (node->dirty) {
+            refresh(node);
+        }
+    }
+    dirtyNodes.clear();
+}
+
+void Scene::destroySubtree(SceneNode *node)
+{
+    for (SceneNode *child: node->children) {
+        destroySubtree(child);
+    }
+    grid.remove(node, node->worldBounds);
+    watchMesh(node, node->mesh, nullptr);
+    if (node->dirty) {
+        dirtyNodes.erase(std::find(dirtyNodes.begin(), dirtyNodes.end(), node));
+    }
+    delete node;
+}
+
+void Scene::invalidate(SceneNode *node)
+{
+    dirtyNodes.push_back(node);
+}
+
+void Scene::refresh(SceneNode *node)
+{
+    if (node->parent) {
+        node->worldPosition = node->parent->worldPosition + node->parent->worldScale * node->position;
+        node->worldScale = node->parent->worldScale * node->scale;
+    } else {
+        node->worldPosition = node->position;
+        node->worldScale = node->scale;
+    }
+
+    BoundingBox bounds = node->mesh ? node->mesh->getBounds().transform(node->worldPosition, node->worldScale) : BoundingBox();
+    if (bounds != node->worldBounds) {
+        grid.move(node, node->worldBounds, bounds);
+        node->worldBounds = bounds;
+    }
+    node->dirty = false;
+    for (SceneNode *child: node->children) {
+        refresh(child);
+    }
+}
+
+void Scene::watchChanges(const Mesh *mesh)
+{
+    // The mesh keeps telling the scene about its changes once no node draws
+    // it, as it may be destroyed first; the scene registers only once
+    for (const std::weak_ptr<std::vector<const Mesh *>> &changeList: mesh->changeLists) {
+        if (changeList.lock() == changedMeshes) {
+            return;
+        }
+    }
+    mesh->changeLists.push_back(changedMeshes);
+}
+
+void Scene::watchMesh(SceneNode *node, const Mesh *oldMesh, const Mesh *newMesh)
+{
+    if (oldMesh == newMesh) {
+        return;
+    }
+    if (oldMesh) {
+        std::vector<SceneNode *> &nodes = meshNodes[oldMesh].nodes;
+        nodes.erase(std::find(nodes.begin(), nodes.end(), node));
+        if (nodes.empty()) {
+            meshNodes.erase(oldMesh);
+        }
+    }
+    if (newMesh) {
+        MeshNodes &meshNode = meshNodes[newMesh];
+        if (meshNode.nodes.empty()) {
+            meshNode.generation = newMesh->getGeneration();
+            watchChanges(newMesh);
+        }
+        meshNode.nodes.push_back(node);
+    }
+}
+
 }
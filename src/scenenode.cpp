@@ -0,0 +1,49 @@
+
+#include "pinta/scenenode.h"
+#include "pinta/scene.h"
+
+namespace pinta {
+
+SceneNode::SceneNode(Scene *scene, SceneNode *parent, unsigned int id):
+    scene(scene), parent(parent), id(id), mesh(nullptr), position(0.0, 0.0), scale(1.0, 1.0), color(255, 255, 255),
+    layer(0), worldPosition(0.0, 0.0), worldScale(1.0, 1.0), dirty(false)
+{
+}
+
+SceneNode::~SceneNode()
+{
+}
+
+DrawItem SceneNode::getDrawItem() const
+{
+    return DrawItem(mesh, worldPosition, worldScale, state, layer, color);
+}
+
+void SceneNode::setMesh(const Mesh *mesh)
+{
+    scene->watchMesh(this, this->mesh, mesh);
+    this->mesh = mesh;
+    invalidate();
+}
+
+void SceneNode::setPosition(const glm::vec2 &position)
+{
+    this->position = position;
+    invalidate();
+}
+
+void SceneNode::setScale(const glm::vec2 &scale)
+{
+    this->scale = scale;
+    invalidate();
+}
+
+void SceneNode::invalidate()
+{
+    if (!dirty) {
+        dirty = true;
+        scene->invalidate(this);
+    }
+}
+
+}
@@ -0,0 +1,28 @@
+#include "pinta/sdfshape.h"
+
+#include <algorithm>
+
+namespace pinta {
+
+SdfShape::SdfShape(const glm::vec2 &position, float width, float height, float cornerRadius, float thickness,
+        const Color &color):
+    position(position), width(width), height(height), cornerRadius(cornerRadius), thickness(thickness), color(color)
+{
+}
+
+SdfShape SdfShape::circle(const glm::vec2 &position, float radius, const Color &color)
+{
+    return SdfShape(position, radius * 2, radius * 2, radius, 0, color);
+}
+
+SdfShape SdfShape::rectangle(const glm::vec2 &position, float w, float h, float cornerRadius, const Color &color)
+{
+    return SdfShape(position, w, h, std::min(cornerRadius, std::min(w, h) / 2), 0, color);
+}
+
+SdfShape SdfShape::ring(const glm::vec2 &position, float radius, float thickness, const Color &color)
+{
+    return SdfShape(position, radius * 2, radius * 2, radius, thickness, color);
+}
+
+}
@@ -0,0 +1,51 @@
+
+#include "pinta/shaderanimation.h"
+
+namespace pinta {
+
+const int ShaderAnimation::UNIFORMS;
+
+static glm::vec4 asVector(const Color &color);
+
+ShaderAnimation::ShaderAnimation(float duration, AnimationEngine::Easing easing, Repeat repeat, float startTime):
+    duration(duration), easing(easing), repeat(repeat)
+{
+    // Timing, weights of the repeat modes, easing, offsets, scales and colors
+    const float *coefficients = AnimationEngine::getEasingCoefficients(easing);
+    uniforms[0] = glm::vec4(startTime, duration > 0 ? 1 / duration : 0, 0.0, 0.0);
+    uniforms[1] = glm::vec4(repeat == ONCE, repeat == LOOP, repeat == ALTERNATE, 0.0);
+    uniforms[2] = glm::vec4(coefficients[0], coefficients[1], coefficients[2], 0.0);
+    uniforms[3] = glm::vec4(0.0, 0.0, 0.0, 0.0);
+    uniforms[4] = glm::vec4(1.0, 1.0, 1.0, 1.0);
+    uniforms[5] = glm::vec4(1.0, 1.0, 1.0, 1.0);
+    uniforms[6] = glm::vec4(1.0, 1.0, 1.0, 1.0);
+}
+
+void ShaderAnimation::setAlpha(float startAlpha, float endAlpha)
+{
+    uniforms[5].a = startAlpha;
+    uniforms[6].a = endAlpha;
+}
+
+void ShaderAnimation::setColor(const Color &startColor, const Color &endColor)
+{
+    uniforms[5] = asVector(startColor);
+    uniforms[6] = asVector(endColor);
+}
+
+void ShaderAnimation::setOffset(const glm::vec2 &startOffset, const glm::vec2 &endOffset)
+{
+    uniforms[3] = glm::vec4(startOffset.x, startOffset.y, endOffset.x, endOffset.y);
+}
+
+void ShaderAnimation::setScale(const glm::vec2 &startScale, const glm::vec2 &endScale)
+{
+    uniforms[4] = glm::vec4(startScale.x, startScale.y, endScale.x, endScale.y);
+}
+
+glm::vec4 asVector(const Color &color)
+{
+    return glm::vec4(color.getRed() / 255.0, color.getGreen() / 255.0, color.getBlue() / 255.0, color.getAlpha() / 255.0);
+}
+
+}
@@ -0,0 +1,26 @@
+
+#include "pinta/shapedescription.h"
+
+#include <cassert>
+
+namespace pinta {
+
+ShapeDescription::ShapeDescription(Type type, float width, float height, float cornerRadius, int segments,
+        const Color &color):
+    type(type), width(width), height(height), cornerRadius(cornerRadius), segments(segments), color(color)
+{
+    assert(cornerRadius <= 0 || segments > 0);
+
+}
+
+ShapeDescription ShapeDescription::circle(float radius, const Color &color, int segments)
+{
+    return ShapeDescription(CIRCLE, radius * 2, radius * 2, radius, segments, color);
+}
+
+ShapeDescription ShapeDescription::rectangle(float w, float h, float cornerRadius, const Color &color, int segments)
+{
+    return ShapeDescription(RECTANGLE, w, h, cornerRadius, segments, color);
+}
+
+}
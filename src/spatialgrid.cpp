@@ -0,0 +1,128 @@
+
+#include "pinta/spatialgrid.h"
+#include "pinta/scenenode.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pinta {
+
+const float SpatialGrid::MAX_NODE_CELLS = 64;
+
+static void removeNode(std::vector<SceneNode *> &nodes, SceneNode *node);
+
+SpatialGrid::SpatialGrid(float cellSize):
+    cellSize(cellSize)
+{
+}
+
+void SpatialGrid::insert(SceneNode *node, const BoundingBox &bounds)
+{
+    if (bounds.isEmpty()) {
+        return;
+    }
+
+    CellRange range = getCells(bounds, MAX_NODE_CELLS);
+    if (range.oversized) {
+        oversizedNodes.push_back(node);
+        return;
+    }
+    for (int x = range.minX; x <= range.maxX; x++) {
+        for (int y = range.minY; y <= range.maxY; y++) {
+            cells[getKey(x, y)].push_back(node);
+        }
+    }
+}
+
+void SpatialGrid::move(SceneNode *node, const BoundingBox &oldBounds, const BoundingBox &newBounds)
+{
+    // Nodes that move inside the same cells stay where they are
+    if (!oldBounds.isEmpty() && !newBounds.isEmpty() && getCells(oldBounds, MAX_NODE_CELLS) == getCells(newBounds, MAX_NODE_CELLS)) {
+        return;
+    }
+    remove(node, oldBounds);
+    insert(node, newBounds);
+}
+
+void SpatialGrid::query(const BoundingBox &area, std::vector<SceneNode *> &nodes) const
+{
+    nodes.clear();
+    if (area.isEmpty()) {
+        return;
+    }
+
+    // Large areas are cheaper to check against the cells in use
+    CellRange range = getCells(area, cells.size());
+    if (range.oversized) {
+        for (const auto &cell: cells) {
+            nodes.insert(nodes.end(), cell.second.begin(), cell.second.end());
+        }
+    } else {
+        for (int x = range.minX; x <= range.maxX; x++) {
+            for (int y = range.minY; y <= range.maxY; y++) {
+                auto cell = cells.find(getKey(x, y));
+                if (cell != cells.end()) {
+                    nodes.insert(nodes.end(), cell->second.begin(), cell->second.end());
+                }
+            }
+        }
+    }
+    nodes.insert(nodes.end(), oversizedNodes.begin(), oversizedNodes.end());
+
+    // Nodes that take several cells are found more than once
+    nodes.erase(std::remove_if(nodes.begin(), nodes.end(),
+        [&area](const SceneNode *node) {return !node->getWorldBounds().intersects(area);}), nodes.end());
+    std::sort(nodes.begin(), nodes.end(), [](const SceneNode *a, const SceneNode *b) {return a->getId() < b->getId();});
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+}
+
+void SpatialGrid::remove(SceneNode *node, const BoundingBox &bounds)
+{
+    if (bounds.isEmpty()) {
+        return;
+    }
+
+    CellRange range = getCells(bounds, MAX_NODE_CELLS);
+    if (range.oversized) {
+        removeNode(oversizedNodes, node);
+        return;
+    }
+    for (int x = range.minX; x <= range.maxX; x++) {
+        for (int y = range.minY; y <= range.maxY; y++) {
+            auto cell = cells.find(getKey(x, y));
+            if (cell == cells.end()) {
+                continue;
+            }
+            removeNode(cell->second, node);
+            if (cell->second.empty()) {
+                cells.erase(cell);
+            }
+        }
+    }
+}
+
+SpatialGrid::CellRange SpatialGrid::getCells(const BoundingBox &bounds, float maxCells) const
+{
+    // Ranges with more than maxCells cells are only flagged as oversized
+    glm::vec2 min = glm::floor(bounds.getMin() / cellSize);
+    glm::vec2 max = glm::floor(bounds.getMax() / cellSize);
+    CellRange range;
+    range.oversized = (max.x - min.x + 1) * (max.y - min.y + 1) > maxCells || std::abs(min.x) > INT32_MAX / 2
+        || std::abs(min.y) > INT32_MAX / 2 || std::abs(max.x) > INT32_MAX / 2 || std::abs(max.y) > INT32_MAX / 2;
+    range.minX = range.oversized ? 0 : int(min.x);
+    range.minY = range.oversized ? 0 : int(min.y);
+    range.maxX = range.oversized ? 0 : int(max.x);
+    range.maxY = range.oversized ? 0 : int(max.y);
+    return range;
+}
+
+void removeNode(std::vector<SceneNode *> &nodes, SceneNode *node)
+{
+    auto it = std::find(nodes.begin(), nodes.end(), node);
+    if (it != nodes.end()) {
+        *it = nodes.back();
+        nodes.pop_back();
+    }
+}
+
+}
@@ -0,0 +1,179 @@
+
+#include "pinta/stats.h"
+#include "pinta/renderererror.h"
+
+#include <chrono>
+#include <iomanip>
+
+namespace pinta {
+
+const int Stats::FRAME_TIME_BUCKETS = 64;
+
+static Stats instance;
+
+Stats::Stats():
+    tracing(false), frames(0), frameTimeHistogram(FRAME_TIME_BUCKETS), frameStart(now()), firstTraceEvent(true)
+{
+    for (std::atomic<uint64_t> &counter: counters) {
+        counter = 0;
+    }
+    for (std::atomic<uint64_t> &phaseTime: phaseTimes) {
+        phaseTime = 0;
+    }
+}
+
+Stats::~Stats()
+{
+    stopTrace();
+}
+
+void Stats::addFrameTime(uint64_t nanoseconds)
+{
+    uint64_t bucket = nanoseconds / 1000000;
+    std::lock_guard<std::mutex> lock(mutex);
+    frameTimeHistogram[bucket < uint64_t(FRAME_TIME_BUCKETS) ? bucket : FRAME_TIME_BUCKETS - 1]++;
+}
+
+void Stats::addPhase(FrameStats::Phase phase, uint64_t start, uint64_t end)
+{
+    phaseTimes[phase].fetch_add(end - start, std::memory_order_relaxed);
+    if (!tracing.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (trace.is_open()) {
+        traceEvents.push_back(TraceEvent{phase, start, end});
+    }
+}
+
+void Stats::endFrame()
+{
+    // What other threads add meanwhile goes to the next frame
+    FrameStats frame;
+    for (int counter = 0; counter < FrameStats::COUNTERS; counter++) {
+        frame.add(static_cast<FrameStats::Counter>(counter), counters[counter].exchange(0));
+    }
+    for (int phase = 0; phase < FrameStats::PHASES; phase++) {
+        frame.addPhaseTime(static_cast<FrameStats::Phase>(phase), phaseTimes[phase].exchange(0));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    lastFrame = frame;
+    total.add(frame);
+    frames++;
+    if (trace.is_open()) {
+        writeTrace();
+    }
+    frameStart = now();
+}
+
+std::vector<uint64_t> Stats::getFrameTimeHistogram() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return frameTimeHistogram;
+}
+
+unsigned long Stats::getFrames() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return frames;
+}
+
+FrameStats Stats::getLastFrame() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastFrame;
+}
+
+FrameStats Stats::getTotal() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return total;
+}
+
+bool Stats::isEnabled()
+{
+#ifdef PINTA_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Stats::isTracing() const
+{
+    return tracing;
+}
+
+uint64_t Stats::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Stats::reset()
+{
+    for (std::atomic<uint64_t> &counter: counters) {
+        counter = 0;
+    }
+    for (std::atomic<uint64_t> &phaseTime: phaseTimes) {
+        phaseTime = 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    lastFrame.clear();
+    total.clear();
+    frames = 0;
+    frameTimeHistogram.assign(FRAME_TIME_BUCKETS, 0);
+}
+
+void Stats::startTrace(const std::string &path)
+{
+    stopTrace();
+    std::lock_guard<std::mutex> lock(mutex);
+    trace.open(path);
+    if (!trace) {
+        throw RendererError("cannot open the trace file " + path);
+    }
+    trace << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    firstTraceEvent = true;
+    traceEvents.clear();
+    tracing = true;
+}
+
+void Stats::stopTrace()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    tracing = false;
+    if (trace.is_open()) {
+        trace << "\n]}\n";
+        trace.close();
+    }
+}
+
+void Stats::writeTrace()
+{
+    // Phases are complete events and the counters of the frame a counter
+    // event, with times in microseconds
+    for (const TraceEvent &event: traceEvents) {
+        trace << (firstTraceEvent ? "\n" : ",\n") << "{\"name\": \"" << FrameStats::getPhaseName(event.phase)
+            << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": " << event.start / 1000.0 << ", \"dur\": "
+            << (event.end - event.start) / 1000.0 << "}";
+        firstTraceEvent = false;
+    }
+    traceEvents.clear();
+
+    trace << (firstTraceEvent ? "\n" : ",\n") << "{\"name\": \"frame\", \"ph\": \"X\", \"pid\": 1, \"tid\": 0, \"ts\": "
+        << frameStart / 1000.0 << ", \"dur\": " << (now() - frameStart) / 1000.0 << ", \"args\": {\"frame\": " << frames
+        << "}},\n{\"name\": \"counters\", \"ph\": \"C\", \"pid\": 1, \"ts\": " << frameStart / 1000.0 << ", \"args\": {";
+    for (int counter = 0; counter < FrameStats::COUNTERS; counter++) {
+        FrameStats::Counter name = static_cast<FrameStats::Counter>(counter);
+        trace << (counter ? ", " : "") << "\"" << FrameStats::getCounterName(name) << "\": " << lastFrame.getCounter(name);
+    }
+    trace << "}}";
+    firstTraceEvent = false;
+}
+
+Stats & stats()
+{
+    return instance;
+}
+
+}
@@ -0,0 +1,12 @@
+
+#include "pinta/strokestyle.h"
+
+namespace pinta {
+
+StrokeStyle::StrokeStyle(float width, Join join, Cap cap, float miterLimit):
+    width(width), join(join), cap(cap), miterLimit(miterLimit)
+{
+
+}
+
+}
@@ -0,0 +1,98 @@
+
+#include "pinta/tessellationcache.h"
+
+namespace pinta {
+
+const size_t TessellationCache::DEFAULT_BUDGET = 4 * 1024 * 1024;
+
+TessellationCache::TessellationCache(size_t budget):
+    budget(budget), size(0), hits(0), misses(0)
+{
+
+}
+
+void TessellationCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    size = 0;
+}
+
+std::shared_ptr<const Mesh> TessellationCache::find(const TessellationKey &key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        misses++;
+        return nullptr;
+    }
+
+    // Move the entry to the front, the least recently used are at the back
+    hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+size_t TessellationCache::getBudget() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget;
+}
+
+unsigned long TessellationCache::getHits() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+unsigned long TessellationCache::getMisses() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+size_t TessellationCache::getSize() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return size;
+}
+
+std::shared_ptr<const Mesh> TessellationCache::insert(const TessellationKey &key, Mesh *mesh)
+{
+    std::shared_ptr<const Mesh> sharedMesh(mesh);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        size -= getMeshSize(*it->second->second);
+        entries.erase(it->second);
+    }
+    entries.push_front(std::make_pair(key, sharedMesh));
+    index[key] = entries.begin();
+    size += getMeshSize(*mesh);
+    trim();
+    return sharedMesh;
+}
+
+void TessellationCache::setBudget(size_t budget)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->budget = budget;
+    trim();
+}
+
+size_t TessellationCache::getMeshSize(const Mesh &mesh)
+{
+    return mesh.getVertices().size() * sizeof(Vertex) + mesh.getIndices().size() * sizeof(GLuint);
+}
+
+void TessellationCache::trim()
+{
+    while (size > budget && !entries.empty()) {
+        size -= getMeshSize(*entries.back().second);
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+}
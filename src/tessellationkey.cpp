@@ -0,0 +1,29 @@
+
+#include "pinta/tessellationkey.h"
+
+#include <functional>
+
+namespace pinta {
+
+TessellationKey::TessellationKey(Shape shape, float w, float h, float cornerRadius, int segments):
+    shape(shape), w(w), h(h), cornerRadius(cornerRadius), segments(segments)
+{
+
+}
+
+bool TessellationKey::operator==(const TessellationKey &other) const
+{
+    return shape == other.shape && w == other.w && h == other.h && cornerRadius == other.cornerRadius
+        && segments == other.segments;
+}
+
+size_t TessellationKey::getHash() const
+{
+    size_t hash = std::hash<int>()(shape);
+    hash = hash * 31 + std::hash<float>()(w);
+    hash = hash * 31 + std::hash<float>()(h);
+    hash = hash * 31 + std::hash<float>()(cornerRadius);
+    return hash * 31 + std::hash<int>()(segments);
+}
+
+}
@@ -0,0 +1,147 @@
+
+#include "pinta/threadpool.h"
+
+#include <algorithm>
+
+namespace pinta {
+
+const size_t ThreadPool::CHUNK_SIZE = 8;
+
+ThreadPool::ThreadPool(unsigned int threads):
+    threads(std::max(threads, 1u)), queues(new Queue[this->threads]), task(nullptr), remaining(0), job(0),
+    stopping(false)
+{
+    for (unsigned int i = 0; i < this->threads; i++) {
+        queues[i].begin = queues[i].end = 0;
+    }
+    // The calling thread works on the first queue
+    for (unsigned int i = 1; i < this->threads; i++) {
+        workers.push_back(std::thread(&ThreadPool::wait, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobCondition.notify_all();
+    for (std::thread &worker: workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)> &task)
+{
+    if (count == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(runMutex);
+    this->task = &task;
+    remaining = count;
+    for (unsigned int i = 0; i < threads; i++) {
+        std::lock_guard<std::mutex> lock(queues[i].mutex);
+        queues[i].begin = count * i / threads;
+        queues[i].end = count * (i + 1) / threads;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job++;
+    }
+    jobCondition.notify_all();
+
+    work(0);
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this]() {return remaining == 0;});
+    this->task = nullptr;
+    if (error) {
+        std::exception_ptr jobError = error;
+        error = nullptr;
+        std::rethrow_exception(jobError);
+    }
+}
+
+bool ThreadPool::steal(unsigned int queue)
+{
+    // Take the second half of what is left in the first queue that has work
+    for (unsigned int i = 1; i < threads; i++) {
+        Queue &victim = queues[(queue + i) % threads];
+        size_t begin;
+        size_t end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.begin == victim.end) {
+                continue;
+            }
+            end = victim.end;
+            begin = victim.end - (victim.end - victim.begin + 1) / 2;
+            victim.end = begin;
+        }
+        std::lock_guard<std::mutex> lock(queues[queue].mutex);
+        queues[queue].begin = begin;
+        queues[queue].end = end;
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::take(unsigned int queue, size_t &begin, size_t &end)
+{
+    std::lock_guard<std::mutex> lock(queues[queue].mutex);
+    if (queues[queue].begin == queues[queue].end) {
+        return false;
+    }
+    begin = queues[queue].begin;
+    end = std::min(begin + CHUNK_SIZE, queues[queue].end);
+    queues[queue].begin = end;
+    return true;
+}
+
+void ThreadPool::wait(unsigned int queue)
+{
+    unsigned long lastJob = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobCondition.wait(lock, [&]() {return stopping || job != lastJob;});
+            if (stopping) {
+                return;
+            }
+            lastJob = job;
+        }
+        work(queue);
+    }
+}
+
+void ThreadPool::work(unsigned int queue)
+{
+    size_t begin;
+    size_t end;
+    while (take(queue, begin, end) || (steal(queue) && take(queue, begin, end))) {
+        // The task is read after taking a chunk, so it is the one of the chunk
+        try {
+            for (size_t i = begin; i < end; i++) {
+                (*task)(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        if (remaining.fetch_sub(end - begin) == end - begin) {
+            std::lock_guard<std::mutex> lock(mutex);
+            doneCondition.notify_all();
+        }
+    }
+}
+
+ThreadPool & threadPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+}
@@ -0,0 +1,87 @@
+
+#include "pinta/transform2d.h"
+
+#include <cmath>
+
+namespace pinta {
+
+Transform2D::Transform2D():
+    Transform2D(1.0, 0.0, 0.0, 0.0, 1.0, 0.0)
+{
+}
+
+Transform2D::Transform2D(float xx, float xy, float x, float yx, float yy, float y):
+    m{{xx, xy, x}, {yx, yy, y}}
+{
+}
+
+Transform2D Transform2D::operator*(const Transform2D &other) const
+{
+    const float (&o)[2][3] = other.m;
+    return Transform2D(m[0][0] * o[0][0] + m[0][1] * o[1][0], m[0][0] * o[0][1] + m[0][1] * o[1][1],
+        m[0][0] * o[0][2] + m[0][1] * o[1][2] + m[0][2],
+        m[1][0] * o[0][0] + m[1][1] * o[1][0], m[1][0] * o[0][1] + m[1][1] * o[1][1],
+        m[1][0] * o[0][2] + m[1][1] * o[1][2] + m[1][2]);
+}
+
+bool Transform2D::operator==(const Transform2D &other) const
+{
+    for (int row = 0; row < 2; row++) {
+        for (int column = 0; column < 3; column++) {
+            if (m[row][column] != other.m[row][column]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+glm::vec2 Transform2D::apply(const glm::vec2 &point) const
+{
+    return glm::vec2(m[0][0] * point.x + m[0][1] * point.y + m[0][2], m[1][0] * point.x + m[1][1] * point.y + m[1][2]);
+}
+
+glm::vec2 Transform2D::getScale() const
+{
+    return glm::vec2(std::sqrt(m[0][0] * m[0][0] + m[1][0] * m[1][0]), std::sqrt(m[0][1] * m[0][1] + m[1][1] * m[1][1]));
+}
+
+Transform2D Transform2D::inverse() const
+{
+    float determinant = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+    float xx = m[1][1] / determinant;
+    float xy = -m[0][1] / determinant;
+    float yx = -m[1][0] / determinant;
+    float yy = m[0][0] / determinant;
+    return Transform2D(xx, xy, -(xx * m[0][2] + xy * m[1][2]), yx, yy, -(yx * m[0][2] + yy * m[1][2]));
+}
+
+void Transform2D::rotate(float angle)
+{
+    // Counterclockwise, in radians
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    for (int row = 0; row < 2; row++) {
+        float x = m[row][0];
+        float y = m[row][1];
+        m[row][0] = x * c + y * s;
+        m[row][1] = y * c - x * s;
+    }
+}
+
+void Transform2D::scale(const glm::vec2 &scaleFactor)
+{
+    for (int row = 0; row < 2; row++) {
+        m[row][0] *= scaleFactor.x;
+        m[row][1] *= scaleFactor.y;
+    }
+}
+
+void Transform2D::translate(const glm::vec2 &position)
+{
+    for (int row = 0; row < 2; row++) {
+        m[row][2] += m[row][0] * position.x + m[row][1] * position.y;
+    }
+}
+
+}